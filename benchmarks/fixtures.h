@@ -0,0 +1,132 @@
+#ifndef FIXTURES_H
+#define FIXTURES_H
+
+#include <QObject>
+
+class A : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int integer READ integer WRITE setInteger NOTIFY integerChanged FINAL)
+    Q_PROPERTY(QString string READ string WRITE setString NOTIFY stringChanged FINAL)
+    Q_PROPERTY(QList<int> numbers READ numbers WRITE setNumbers NOTIFY numbersChanged FINAL)
+
+public:
+    Q_INVOKABLE explicit A(QObject *parent = nullptr)
+        : QObject{parent}
+        , m_integer{0}
+    {}
+
+    int integer() const { return m_integer; }
+    void setInteger(int newInteger)
+    {
+        if (m_integer == newInteger)
+            return;
+        m_integer = newInteger;
+        emit integerChanged();
+    }
+
+    QString string() const { return m_string; }
+    void setString(const QString &newString)
+    {
+        if (m_string == newString)
+            return;
+        m_string = newString;
+        emit stringChanged();
+    }
+
+    QList<int> numbers() const { return m_numbers; }
+    void setNumbers(const QList<int> &newNumbers)
+    {
+        if (m_numbers == newNumbers)
+            return;
+        m_numbers = newNumbers;
+        emit numbersChanged();
+    }
+
+public slots:
+    int add(int x, int y) { return x + y; };
+
+signals:
+    void integerChanged();
+    void stringChanged();
+    void numbersChanged();
+
+private:
+    int m_integer;
+    QString m_string;
+    QList<int> m_numbers;
+};
+
+// a tree node owning its children, grow() builds a tree with the given number of children per level
+class Node : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int value READ value WRITE setValue NOTIFY valueChanged FINAL)
+    Q_PROPERTY(QString name READ name WRITE setName NOTIFY nameChanged FINAL)
+    Q_PROPERTY(QList<Node *> children READ children WRITE setChildren NOTIFY childrenChanged FINAL)
+
+public:
+    Q_INVOKABLE explicit Node(QObject *parent = nullptr)
+        : QObject{parent}
+        , m_value{0}
+    {}
+
+    ~Node() override { qDeleteAll(m_children); }
+
+    void grow(const QList<int> &widths)
+    {
+        if (widths.isEmpty())
+            return;
+
+        QList<Node *> children;
+
+        for (int i = 0; i < widths.first(); ++i) {
+            auto child = new Node{};
+            child->setValue(i);
+            child->setName(QString{"node %1"}.arg(i));
+            child->grow(widths.mid(1));
+            children.append(child);
+        }
+
+        setChildren(children);
+    }
+
+    int value() const { return m_value; }
+    void setValue(int newValue)
+    {
+        if (m_value == newValue)
+            return;
+        m_value = newValue;
+        emit valueChanged();
+    }
+
+    QString name() const { return m_name; }
+    void setName(const QString &newName)
+    {
+        if (m_name == newName)
+            return;
+        m_name = newName;
+        emit nameChanged();
+    }
+
+    const QList<Node *> &children() const { return m_children; }
+    void setChildren(const QList<Node *> &newChildren)
+    {
+        if (m_children == newChildren)
+            return;
+        m_children = newChildren;
+        emit childrenChanged();
+    }
+
+signals:
+    void valueChanged();
+    void nameChanged();
+    void childrenChanged();
+
+private:
+    int m_value;
+    QString m_name;
+    QList<Node *> m_children;
+};
+
+#endif // FIXTURES_H
@@ -0,0 +1,82 @@
+#include <QtTest/QTest>
+
+#include "fixtures.h"
+#include "json.h"
+
+class JSONBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase() { qRegisterMetaType<Node *>(); }
+
+    void serialize_data()
+    {
+        QTest::addColumn<QList<int>>("widths");
+
+        QTest::newRow("wide") << QList<int>{1000};
+        QTest::newRow("deep") << QList<int>{2, 2, 2, 2, 2, 2, 2, 2, 2, 2};
+        QTest::newRow("both") << QList<int>{10, 10, 10};
+    }
+
+    void serialize()
+    {
+        QFETCH(QList<int>, widths);
+
+        Node root{};
+        root.grow(widths);
+
+        QJsonValue value;
+
+        QBENCHMARK {
+            value = JSON::serialize(&root);
+        }
+
+        QVERIFY(value.isObject());
+    }
+
+    void deserialize_data() { serialize_data(); }
+
+    void deserialize()
+    {
+        QFETCH(QList<int>, widths);
+
+        Node root{};
+        root.grow(widths);
+
+        const auto value = JSON::serialize(&root);
+
+        QBENCHMARK {
+            delete JSON::deserialize<Node *>(value);
+        }
+    }
+
+    void write_data()
+    {
+        QTest::addColumn<QVariant>("value");
+        QTest::addColumn<QByteArray>("json");
+
+        QTest::newRow("int") << QVariant{42} << QByteArray{"42"};
+        QTest::newRow("double") << QVariant{0.5} << QByteArray{"0.5"};
+        QTest::newRow("string") << QVariant{QString{"a \"b\"\n"}} << QByteArray{R"("a \"b\"\n")"};
+    }
+
+    void write()
+    {
+        QFETCH(QVariant, value);
+        QFETCH(QByteArray, json);
+
+        QByteArray frame;
+
+        QBENCHMARK {
+            frame.clear();
+            JSON::write(frame, value);
+        }
+
+        QCOMPARE(frame, json);
+    }
+};
+
+#include "json-benchmark.moc"
+
+QTEST_MAIN(JSONBenchmark)
@@ -0,0 +1,113 @@
+#include <memory>
+#include <vector>
+
+#include <QtTest/QTest>
+
+#include "fixtures.h"
+#include "jsonadapter.h"
+#include "qobjectregistry.h"
+
+class RegistryBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void registerObjects_data()
+    {
+        QTest::addColumn<bool>("lazy");
+
+        QTest::newRow("eager") << false;
+        QTest::newRow("lazy") << true;
+    }
+
+    void registerObjects()
+    {
+        QFETCH(bool, lazy);
+
+        // 1 + 1000 + 9000 objects, every one of them with a list of children
+        Node root{};
+        root.grow({1000, 9});
+
+        QObjectRegistry registry{};
+        registry.setLazy(lazy);
+
+        QBENCHMARK {
+            registry.registerObject("root", &root);
+            registry.deregisterObject("root");
+        }
+    }
+
+    void get()
+    {
+        QObjectRegistry registry{};
+
+        A a{};
+        a.setInteger(2112);
+        registry.registerObject("a", &a);
+
+        QVariant value;
+
+        QBENCHMARK {
+            value = registry.get("a.integer");
+        }
+
+        QCOMPARE(value.toInt(), 2112);
+    }
+
+    void set()
+    {
+        QObjectRegistry registry{};
+
+        A a{};
+        registry.registerObject("a", &a);
+
+        int i = 0;
+
+        QBENCHMARK {
+            registry.set("a.integer", ++i);
+        }
+
+        QCOMPARE(a.integer(), i);
+    }
+
+    void notifyFanOut_data()
+    {
+        QTest::addColumn<int>("adapters");
+
+        QTest::newRow("1") << 1;
+        QTest::newRow("10") << 10;
+        QTest::newRow("100") << 100;
+    }
+
+    void notifyFanOut()
+    {
+        QFETCH(int, adapters);
+
+        QObjectRegistry registry{};
+
+        A a{};
+        registry.registerObject("a", &a);
+
+        std::vector<std::unique_ptr<JSONAdapter>> clients;
+        qint64 messages = 0;
+
+        for (int i = 0; i < adapters; ++i) {
+            clients.push_back(std::make_unique<JSONAdapter>(registry));
+            connect(clients.back().get(), &JSONAdapter::sendMessage, this, [&messages](const QByteArray &) { ++messages; });
+            clients.back()->handleMessage(R"({"type": "subscribe", "key": "a.integer"})");
+        }
+
+        messages = 0;
+        int i = 0;
+
+        QBENCHMARK {
+            a.setInteger(++i);
+        }
+
+        QCOMPARE(messages, qint64(i) * adapters);
+    }
+};
+
+#include "registry-benchmark.moc"
+
+QTEST_MAIN(RegistryBenchmark)
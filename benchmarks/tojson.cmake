@@ -0,0 +1,41 @@
+# turns the QtTest xml logs of the benchmarks into one json document, one entry per result:
+# {"benchmarks": [{"benchmark", "function", "tag", "metric", "value", "iterations"}, ...]}
+
+string(REPLACE "," ";" benchmarks "${BENCHMARKS}")
+
+set(json "{\"benchmarks\": []}")
+set(index 0)
+
+foreach(benchmark ${benchmarks})
+    file(READ "${INPUT_DIR}/${benchmark}.xml" xml)
+    string(REGEX MATCHALL "<TestFunction name=\"[^\"]*\"|<BenchmarkResult [^>]*>" elements "${xml}")
+
+    set(function "")
+
+    foreach(element ${elements})
+        if (element MATCHES "^<TestFunction name=\"([^\"]*)\"")
+            set(function "${CMAKE_MATCH_1}")
+            continue()
+        endif()
+
+        set(result "{}")
+        string(JSON result SET "${result}" benchmark "\"${benchmark}\"")
+        string(JSON result SET "${result}" function "\"${function}\"")
+
+        foreach(attribute metric tag)
+            string(REGEX MATCH " ${attribute}=\"([^\"]*)\"" match "${element}")
+            string(JSON result SET "${result}" ${attribute} "\"${CMAKE_MATCH_1}\"")
+        endforeach()
+
+        foreach(attribute value iterations)
+            string(REGEX MATCH " ${attribute}=\"([^\"]*)\"" match "${element}")
+            string(JSON result SET "${result}" ${attribute} "${CMAKE_MATCH_1}")
+        endforeach()
+
+        string(JSON json SET "${json}" benchmarks ${index} "${result}")
+        math(EXPR index "${index} + 1")
+    endforeach()
+endforeach()
+
+file(WRITE "${OUTPUT}" "${json}\n")
+message(STATUS "wrote ${index} benchmark results to ${OUTPUT}")
@@ -0,0 +1,115 @@
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtTest/QSignalSpy>
+#include <QtTest/QTest>
+#include <QtWebSockets/QWebSocket>
+#include <QtWebSockets/QWebSocketHandshakeOptions>
+
+#include "fixtures.h"
+#include "qobjectregistry.h"
+#include "websocketserver.h"
+
+class WebSocketBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void roundTrip_data()
+    {
+        QTest::addColumn<QString>("message");
+        QTest::addColumn<int>("workers");
+
+        QTest::newRow("get") << R"({"type": "get", "key": "a.integer"})" << 0;
+        QTest::newRow("call") << R"({"type": "call", "key": "a.add", "args": [1, 2]})" << 0;
+        QTest::newRow("get in worker") << R"({"type": "get", "key": "a.integer"})" << 2;
+        QTest::newRow("call in worker") << R"({"type": "call", "key": "a.add", "args": [1, 2]})" << 2;
+    }
+
+    // a request over loopback and its return, with workers the adapter hops over to our thread and back
+    void roundTrip()
+    {
+        QFETCH(QString, message);
+        QFETCH(int, workers);
+
+        QObjectRegistry registry{};
+
+        A a{};
+        registry.registerObject("a", &a);
+
+        WebSocketServer server{registry, workers};
+
+        QWebSocket socket{};
+        QSignalSpy connected{&socket, &QWebSocket::connected};
+        socket.open(QUrl{"ws://127.0.0.1:21120"});
+        QVERIFY(connected.wait());
+
+        QSignalSpy received{&socket, &QWebSocket::textMessageReceived};
+
+        QBENCHMARK {
+            socket.sendTextMessage(message);
+            QVERIFY(received.wait());
+            received.clear();
+        }
+
+        socket.close();
+    }
+
+    void notifyBurst_data()
+    {
+        QTest::addColumn<QString>("subprotocol");
+
+        QTest::newRow("frame per notify") << "qopenremote.json";
+        QTest::newRow("batched") << "qopenremote.json.batch";
+    }
+
+    // a hundred changes in one event loop iteration, until the last of them arrived
+    void notifyBurst()
+    {
+        QFETCH(QString, subprotocol);
+
+        QObjectRegistry registry{};
+
+        A a{};
+        registry.registerObject("a", &a);
+
+        WebSocketServer server{registry};
+
+        QWebSocketHandshakeOptions options{};
+        options.setSubprotocols({subprotocol});
+
+        QWebSocket socket{};
+        QSignalSpy connected{&socket, &QWebSocket::connected};
+        socket.open(QUrl{"ws://127.0.0.1:21120"}, options);
+        QVERIFY(connected.wait());
+        QCOMPARE(socket.subprotocol(), subprotocol);
+
+        QSignalSpy received{&socket, &QWebSocket::textMessageReceived};
+        socket.sendTextMessage(R"({"type": "subscribe", "key": "a.integer"})");
+        QVERIFY(received.wait());
+        received.clear();
+
+        const auto lastValue = [&received] {
+            const auto document = QJsonDocument::fromJson(received.last()[0].toString().toUtf8());
+            return (document.isArray() ? document.array().last().toObject() : document.object())["value"].toInt();
+        };
+
+        int value = a.integer();
+
+        QBENCHMARK {
+            for (int i = 0; i < 100; ++i)
+                a.setInteger(++value);
+
+            while (received.isEmpty() || lastValue() != value)
+                QVERIFY(received.wait());
+
+            received.clear();
+        }
+
+        socket.close();
+    }
+};
+
+#include "websocket-benchmark.moc"
+
+QTEST_MAIN(WebSocketBenchmark)
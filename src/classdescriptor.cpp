@@ -0,0 +1,154 @@
+#include "classdescriptor.h"
+
+#include <QLoggingCategory>
+#include <QMutex>
+#include <QSequentialIterable>
+
+namespace {
+Q_LOGGING_CATEGORY(self, "descriptor", QtWarningMsg)
+
+// the flags in the header moc writes for a meta object, QMetaObjectPrivate::flags
+constexpr int FlagsField = 12;
+constexpr uint DynamicMetaObject = 0x01;
+
+bool isDynamic(const QMetaObject *metaObject)
+{
+    return metaObject->d.data[FlagsField] & DynamicMetaObject;
+}
+} // namespace
+
+std::shared_ptr<const ClassDescriptor> ClassDescriptor::forMetaObject(const QMetaObject *metaObject)
+{
+    // a dynamic meta object may be freed along with its instance and its address taken by
+    // another one, so its descriptor is not cached
+    if (isDynamic(metaObject)) {
+        qCInfo(self) << "create descriptor for dynamic" << metaObject->className();
+        return std::shared_ptr<const ClassDescriptor>{new ClassDescriptor{metaObject}};
+    }
+
+    // static meta objects live until the program ends, so do their descriptors
+    static QMutex mutex;
+    static QHash<const QMetaObject *, std::shared_ptr<const ClassDescriptor>> descriptors;
+
+    QMutexLocker locker{&mutex};
+    auto &descriptor = descriptors[metaObject];
+
+    if (descriptor == nullptr) {
+        qCInfo(self) << "create descriptor for" << metaObject->className();
+        descriptor.reset(new ClassDescriptor{metaObject});
+    }
+
+    return descriptor;
+}
+
+ClassDescriptor::Kind ClassDescriptor::kindOf(const QMetaType &type)
+{
+    if (type.flags().testFlag(QMetaType::PointerToQObject))
+        return Object;
+
+    if (type.id() != QMetaType::QString && QMetaType::canConvert(type, QMetaType::fromType<QVariantList>()))
+        return List;
+
+    return Value;
+}
+
+bool ClassDescriptor::holdsObjects(const QMetaType &listType)
+{
+    // an empty list tells its element type. variants may hold anything
+    const QVariant list{listType};
+
+    if (!list.canView<QSequentialIterable>())
+        return true;
+
+    const auto element = list.view<QSequentialIterable>().metaContainer().valueMetaType();
+    return element.id() == QMetaType::QVariant || element.flags().testFlag(QMetaType::PointerToQObject);
+}
+
+ClassDescriptor::ClassDescriptor(const QMetaObject *metaObject)
+    : _metaObject{metaObject}
+{
+    _properties.reserve(metaObject->propertyCount());
+
+    for (int i = 0; i < metaObject->propertyCount(); ++i) {
+        const auto property = metaObject->property(i);
+        const auto type = property.metaType();
+        const auto dynamic = type.id() == QMetaType::QVariant;
+        const auto kind = dynamic ? Value : kindOf(type);
+
+        _properties.append(Property{
+            property,
+            QString::fromLatin1(property.name()),
+            type,
+            kind,
+            dynamic,
+            kind == List && holdsObjects(type),
+            property.notifySignalIndex(),
+        });
+
+        if (property.hasNotifySignal())
+            _notifyProperties[property.notifySignalIndex()].append(i);
+    }
+
+    QHash<QString, int> methodIndexes;
+    QHash<QString, int> signalIndexes;
+
+    for (int i = 0; i < metaObject->methodCount(); ++i) {
+        const auto method = metaObject->method(i);
+        const auto name = QString::fromLatin1(method.name());
+
+        // a signal is relayed with all of its arguments, the shorter overloads are the same emission
+
+        if (method.methodType() == QMetaMethod::Signal) {
+            const auto it = signalIndexes.constFind(name);
+
+            if (it == signalIndexes.cend()) {
+                signalIndexes.insert(name, _signals.size());
+                _signals.append(Signal{name, method});
+            } else if (_signals[*it].method.parameterCount() < method.parameterCount()) {
+                _signals[*it].method = method;
+            }
+
+            continue;
+        }
+
+        // the slots of QObject itself are not for clients, deleteLater would let them delete any registered object
+        if (method.access() != QMetaMethod::Public || i < QObject::staticMetaObject.methodCount())
+            continue;
+
+        // overloads and default arguments share one name, calls pick them by argument count
+
+        auto it = methodIndexes.constFind(name);
+
+        if (it == methodIndexes.cend()) {
+            it = methodIndexes.insert(name, _methods.size());
+            _methods.append(Method{name, {}});
+        }
+
+        _methods[*it].overloads.append(MethodInvoker{method});
+    }
+}
+
+const QMetaObject *ClassDescriptor::metaObject() const
+{
+    return _metaObject;
+}
+
+const QList<ClassDescriptor::Property> &ClassDescriptor::properties() const
+{
+    return _properties;
+}
+
+const QList<ClassDescriptor::Method> &ClassDescriptor::methods() const
+{
+    return _methods;
+}
+
+const QList<ClassDescriptor::Signal> &ClassDescriptor::signalMethods() const
+{
+    return _signals;
+}
+
+QList<int> ClassDescriptor::propertiesNotifiedBy(int signal) const
+{
+    return _notifyProperties.value(signal);
+}
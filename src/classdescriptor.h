@@ -0,0 +1,70 @@
+#ifndef CLASSDESCRIPTOR_H
+#define CLASSDESCRIPTOR_H
+
+#include <memory>
+
+#include <QHash>
+#include <QMetaProperty>
+
+#include "methodinvoker.h"
+
+/*
+ * the reflection data the registry needs for a class: its properties with their
+ * notify signals and how to handle their values, its public methods grouped
+ * by name and its signals. descriptors are built once per QMetaObject and shared by every
+ * registered instance of that class. dynamic meta objects, like the ones of objects declared
+ * in qml, belong to a single instance, their descriptors go with the last one holding them.
+ */
+class ClassDescriptor
+{
+public:
+    enum Kind : quint8 {
+        Value,
+        Object,
+        List,
+    };
+
+    struct Property
+    {
+        QMetaProperty property;
+        QString name;
+        QMetaType type;
+        Kind kind;
+        bool dynamic; // QVariant typed, the kind depends on the current value
+        bool objects; // a list whose elements may be objects
+        int notifySignal;
+    };
+
+    struct Method
+    {
+        QString name;
+        QList<MethodInvoker> overloads;
+    };
+
+    struct Signal
+    {
+        QString name;
+        QMetaMethod method; // the overload with the most parameters
+    };
+
+    static std::shared_ptr<const ClassDescriptor> forMetaObject(const QMetaObject *metaObject);
+    static Kind kindOf(const QMetaType &type);
+    static bool holdsObjects(const QMetaType &listType);
+
+    const QMetaObject *metaObject() const;
+    const QList<Property> &properties() const;
+    const QList<Method> &methods() const;
+    const QList<Signal> &signalMethods() const;
+    QList<int> propertiesNotifiedBy(int signal) const;
+
+private:
+    explicit ClassDescriptor(const QMetaObject *metaObject);
+
+    const QMetaObject *_metaObject;
+    QList<Property> _properties;
+    QList<Method> _methods;
+    QList<Signal> _signals;
+    QHash<int, QList<int>> _notifyProperties;
+};
+
+#endif // CLASSDESCRIPTOR_H
@@ -1,5 +1,8 @@
 #include "json.h"
 
+#include <charconv>
+#include <cmath>
+
 #include <QColor>
 #include <QJsonArray>
 #include <QJsonDocument>
@@ -10,7 +13,24 @@
 
 namespace {
 Q_LOGGING_CATEGORY(self, "JSON", QtInfoMsg)
+
+template<class T>
+void writeNumber(QByteArray &json, T number)
+{
+    char buffer[32];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), number);
+    json.append(buffer, result.ptr - buffer);
+}
+
+void writeDouble(QByteArray &json, double number)
+{
+    // like QJsonDocument, json has no representation for these
+    if (!std::isfinite(number))
+        json.append("null");
+    else
+        writeNumber(json, number);
 }
+} // namespace
 
 QHash<int, JSON::Serializer> JSON::_serializers = {
     {
@@ -99,9 +119,14 @@ QJsonValue JSON::serialize(const QVariant &variant)
     if (!variant.isValid())
         return QJsonValue::Undefined;
 
-    auto serializer = _serializers.find(typeId);
+    // serialized before, e.g. in the thread of the objects it references
+    if (typeId == QMetaType::QJsonValue)
+        return variant.toJsonValue();
 
-    if (serializer != _serializers.end())
+    // constFind, the table is shared by the adapters of all threads
+    auto serializer = _serializers.constFind(typeId);
+
+    if (serializer != _serializers.cend())
         return serializer->serialize(variant);
 
     if (metaType.flags().testFlag(QMetaType::PointerToQObject)) {
@@ -137,6 +162,82 @@ QJsonValue JSON::serialize(const QVariant &variant)
     return variant.toJsonValue();
 }
 
+bool JSON::write(QByteArray &json, const QVariant &variant)
+{
+    switch (variant.typeId()) {
+    case QMetaType::Bool:
+        json.append(variant.toBool() ? "true" : "false");
+        return true;
+    case QMetaType::Int:
+        writeNumber(json, variant.toInt());
+        return true;
+    case QMetaType::UInt:
+        writeNumber(json, variant.toUInt());
+        return true;
+    case QMetaType::LongLong:
+        writeNumber(json, variant.toLongLong());
+        return true;
+    case QMetaType::ULongLong:
+        writeNumber(json, variant.toULongLong());
+        return true;
+    case QMetaType::Float:
+    case QMetaType::Double:
+        writeDouble(json, variant.toDouble());
+        return true;
+    case QMetaType::QString:
+        write(json, *static_cast<const QString *>(variant.constData()));
+        return true;
+    default:
+        return false;
+    }
+}
+
+void JSON::write(QByteArray &json, const QString &string)
+{
+    static constexpr char hex[] = "0123456789abcdef";
+
+    json.append('"');
+
+    for (qsizetype i = 0; i < string.size(); ++i) {
+        const auto unicode = string[i].unicode();
+
+        switch (unicode) {
+        case u'"':
+            json.append("\\\"");
+            break;
+        case u'\\':
+            json.append("\\\\");
+            break;
+        case u'\n':
+            json.append("\\n");
+            break;
+        case u'\r':
+            json.append("\\r");
+            break;
+        case u'\t':
+            json.append("\\t");
+            break;
+        default:
+            if (unicode < 0x20) {
+                const char escaped[] = {'\\', 'u', '0', '0', hex[unicode >> 4], hex[unicode & 0xf]};
+                json.append(escaped, sizeof(escaped));
+            } else if (unicode < 0x80) {
+                json.append(char(unicode));
+            } else {
+                // runs of non ascii characters are encoded at once, surrogate pairs stay together
+                auto end = i + 1;
+                while (end < string.size() && string[end].unicode() >= 0x80)
+                    ++end;
+
+                json.append(string.sliced(i, end - i).toUtf8());
+                i = end - 1;
+            }
+        }
+    }
+
+    json.append('"');
+}
+
 QVariant JSON::deserialize(const QJsonValue &value, const QMetaType &type)
 {
     QMetaType targetType = type;
@@ -162,8 +263,8 @@ QVariant JSON::deserialize(const QJsonValue &value, const QMetaType &type)
 
     qCDebug(self) << "trying to deserialize" << value << "into" << type;
 
-    auto serializer = _serializers.find(targetType.id());
-    if (serializer != _serializers.end())
+    auto serializer = _serializers.constFind(targetType.id());
+    if (serializer != _serializers.cend())
         return serializer->deserialize(value);
 
     if (targetType.flags().testFlag(QMetaType::PointerToQObject)) {
@@ -230,5 +331,16 @@ QVariant JSON::deserialize(const QJsonValue &value, const QMetaType &type)
     if (!variant.isValid())
         qCWarning(self) << "default conversion failed:" << value;
 
+    // numbers arrive as doubles and enums as keys or numbers, the target type decides.
+    // a number that would be rounded or cut off is not converted
+    if (variant.isValid() && variant.metaType() != targetType && targetType.id() != QMetaType::QVariant) {
+        auto converted = variant;
+
+        if (converted.convert(targetType) && (!value.isDouble() || converted.toDouble() == value.toDouble()))
+            return converted;
+
+        qCWarning(self) << "cannot convert" << value << "to" << targetType.name();
+    }
+
     return variant;
 }
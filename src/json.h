@@ -19,10 +19,18 @@ public:
     static QJsonValue serialize(const T &t);
     static QJsonValue serialize(const QVariant &variant);
 
+    // plain values are converted to the type, numbers only if they keep their value: 3.0 becomes
+    // an int, 2.5 or 1e10 stay doubles. enums are taken by key or by value. a value that does not
+    // convert comes back as it is, callers needing the type check the type of the result
     template<class T>
     static T deserialize(const QJsonValue &value);
     static QVariant deserialize(const QJsonValue &value, const QMetaType &type = QMetaType());
 
+    // appends booleans, numbers and strings as json text without going through QJsonValue,
+    // false and nothing appended for every other type
+    static bool write(QByteArray &json, const QVariant &variant);
+    static void write(QByteArray &json, const QString &string);
+
 private:
     struct Serializer
     {
@@ -1,39 +1,334 @@
 #include "jsonadapter.h"
 
+#include <memory>
+#include <utility>
+
+#include <QCache>
+#include <QDeadlineTimer>
+#include <QCborMap>
+#include <QCborStreamWriter>
+#include <QCborValue>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QLoggingCategory>
+#include <QMutex>
+#include <QPointer>
+#include <QPromise>
+#include <QSet>
+#include <QTimer>
+#include <QUuid>
 
 #include "json.h"
+#include "registrylink.h"
 
 namespace {
 Q_LOGGING_CATEGORY(self, "adapter.json", QtWarningMsg)
+
+// how long a disconnected client may take to resume, msecs
+constexpr int SessionTimeout = 5 * 60 * 1000;
+
+// the subscriptions of a disconnected client. they stay in the registry so its changes keep
+// being journaled for a resume, and are released when the session is evicted or expires
+struct Session
+{
+    QPointer<QObjectRegistry> registry;
+    QStringList keys;
+    QDeadlineTimer expiry;
+
+    ~Session()
+    {
+        if (!registry || keys.isEmpty())
+            return;
+
+        QMetaObject::invokeMethod(registry, [registry = registry, keys = keys] {
+            for (const auto &key : keys)
+                registry->unsubscribe(key);
+        });
+    }
+};
+
+// sessions of recently disconnected clients by token, shared by the adapters of all threads
+QCache<QString, Session> &sessions()
+{
+    static QCache<QString, Session> sessions{256};
+    return sessions;
 }
 
+QMutex &sessionsMutex()
+{
+    static QMutex mutex;
+    return mutex;
+}
+
+struct FrameKey
+{
+    const QObjectRegistry *registry;
+    int format;
+    QString key;
+
+    friend bool operator==(const FrameKey &a, const FrameKey &b) { return a.registry == b.registry && a.format == b.format && a.key == b.key; }
+    friend size_t qHash(const FrameKey &key, size_t seed = 0) { return qHashMulti(seed, key.registry, key.format, key.key); }
+};
+
+struct Frame
+{
+    quint64 version;
+    QByteArray data;
+};
+
+// the last notify frame of every key and format, shared by the adapters of all threads. a change
+// is encoded by its first subscriber, the others send the same bytes
+struct FrameCache
+{
+    QMutex mutex;
+    QCache<FrameKey, Frame> frames{8 * 1024 * 1024};
+};
+
+FrameCache &frameCache()
+{
+    static FrameCache cache;
+    return cache;
+}
+
+// a value read in the registry thread, with the version it was read at
+struct Reading
+{
+    QString key;
+    QVariant value;
+    quint64 version;
+};
+
+// a set value from a client in the type of its key, invalid if it does not fit. objects are never
+// created from client input, so object properties cannot be set and __typeName is not looked at
+QVariant setValue(const QJsonValue &value, const QMetaType &type)
+{
+    if (!type.isValid())
+        return value.toVariant();
+
+    if (type.flags().testFlag(QMetaType::PointerToQObject)) {
+        qCWarning(self) << "object properties cannot be set:" << type.name();
+        return QVariant{};
+    }
+
+    const auto variant = JSON::deserialize(value, type);
+
+    if (type.id() != QMetaType::QVariant && variant.metaType() != type) {
+        qCWarning(self) << "cannot set" << value << "as" << type.name();
+        return QVariant{};
+    }
+
+    return variant;
+}
+
+// the notify of a bool, number or string written straight into the frame, false for every other value
+bool writeJsonNotify(QByteArray &frame, const QString &key, const QVariant &value, quint64 version)
+{
+    const auto size = frame.size();
+
+    frame.append(R"({"type":"notify","key":)");
+    JSON::write(frame, key);
+    frame.append(R"(,"value":)");
+
+    if (!JSON::write(frame, value)) {
+        frame.truncate(size);
+        return false;
+    }
+
+    frame.append(R"(,"version":)");
+    JSON::write(frame, QVariant{qint64(version)});
+    frame.append('}');
+    return true;
+}
+
+bool writeCborNotify(QByteArray &frame, const QString &key, const QVariant &value, quint64 version)
+{
+    switch (value.typeId()) {
+    case QMetaType::Bool:
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+    case QMetaType::Float:
+    case QMetaType::Double:
+    case QMetaType::QString:
+        break;
+    default:
+        return false;
+    }
+
+    QCborStreamWriter writer{&frame};
+    writer.startMap(4);
+    writer.append(QLatin1String{"type"});
+    writer.append(QLatin1String{"notify"});
+    writer.append(QLatin1String{"key"});
+    writer.append(key);
+    writer.append(QLatin1String{"value"});
+
+    switch (value.typeId()) {
+    case QMetaType::Bool:
+        writer.append(value.toBool());
+        break;
+    case QMetaType::UInt:
+    case QMetaType::ULongLong:
+        writer.append(quint64(value.toULongLong()));
+        break;
+    case QMetaType::Float:
+    case QMetaType::Double:
+        writer.append(value.toDouble());
+        break;
+    case QMetaType::QString:
+        writer.append(*static_cast<const QString *>(value.constData()));
+        break;
+    default:
+        writer.append(qint64(value.toLongLong()));
+        break;
+    }
+
+    writer.append(QLatin1String{"version"});
+    writer.append(quint64(version));
+    writer.endMap();
+    return true;
+}
+} // namespace
+
 JSONAdapter::JSONAdapter(QObjectRegistry &registry, QObject *parent)
+    : JSONAdapter{registry, Json, parent}
+{}
+
+JSONAdapter::JSONAdapter(QObjectRegistry &registry, Format format, QObject *parent)
     : QObject{parent}
     , _registry{registry}
+    , _link{nullptr}
+    , _format{format}
 {
-    connect(&registry, &QObjectRegistry::valueChanged, this, &JSONAdapter::onValueChanged);
+    if (thread() == registry.thread()) {
+        connect(&registry, &QObjectRegistry::valueChanged, this, &JSONAdapter::onValueChanged);
+        connect(&registry, &QObjectRegistry::listChanged, this, &JSONAdapter::onListChanged);
+        connect(&registry, &QObjectRegistry::signalEmitted, this, &JSONAdapter::onSignalEmitted);
+        return;
+    }
+
+    qCDebug(self) << "adapter in" << thread() << "links to the registry in" << registry.thread();
+    _link = new RegistryLink{registry};
+
+    connect(_link, &RegistryLink::valueChanged, this, &JSONAdapter::onValueChanged);
+    connect(_link, &RegistryLink::listChanged, this, &JSONAdapter::onListChanged);
+    connect(_link, &RegistryLink::signalEmitted, this, &JSONAdapter::onSignalEmitted);
 }
 
-void JSONAdapter::handleMessage(const QByteArray &message)
+JSONAdapter::~JSONAdapter()
 {
-    QJsonParseError error;
-    auto doc = QJsonDocument::fromJson(message, &error);
+    QStringList keys;
+    for (auto it = _subscribed.cbegin(); it != _subscribed.cend(); ++it)
+        if (*it > 0)
+            keys.append(it.key());
 
-    if (error.error != QJsonParseError::NoError) {
-        qCWarning(self) << "parse error" << error.errorString() << "in" << message;
-        return;
+    if (!_session.isEmpty()) {
+        // the session takes over our subscriptions until it is resumed, evicted or expired
+        {
+            QMutexLocker locker{&sessionsMutex()};
+            sessions().insert(_session, new Session{&_registry, keys, QDeadlineTimer{SessionTimeout, Qt::PreciseTimer}});
+        }
+
+        post([registry = &_registry, session = _session] {
+            // a coarse timer may fire a little early, before the expiry it checks
+            QTimer::singleShot(SessionTimeout, Qt::PreciseTimer, registry, [session] {
+                std::unique_ptr<Session> expired;
+                {
+                    QMutexLocker locker{&sessionsMutex()};
+                    const auto cached = sessions().object(session);
+
+                    if (cached && cached->expiry.hasExpired())
+                        expired.reset(sessions().take(session));
+                }
+
+                if (expired)
+                    qCInfo(self) << "session expired" << session;
+            });
+        });
+    } else {
+        post([registry = &_registry, keys] {
+            for (const auto &key : keys)
+                registry->unsubscribe(key);
+        });
     }
 
-    if (!doc.isObject()) {
-        qCWarning(self) << "json doc is not an object:" << doc;
+    if (_link)
+        _link->deleteLater();
+}
+
+JSONAdapter::Format JSONAdapter::format() const
+{
+    return _format;
+}
+
+template<class Function>
+void JSONAdapter::post(Function function)
+{
+    if (_link == nullptr)
+        function();
+    else
+        QMetaObject::invokeMethod(&_registry, function, Qt::QueuedConnection);
+}
+
+template<class Function, class Done>
+void JSONAdapter::request(Function function, Done done)
+{
+    if (_link == nullptr) {
+        done(function());
         return;
     }
 
-    auto object = doc.object();
+    // the continuation is dropped if we are gone by the time the result is there
+    auto promise = std::make_shared<QPromise<decltype(function())>>();
+    promise->future().then(this, done);
+    promise->start();
+
+    QMetaObject::invokeMethod(
+        &_registry,
+        [promise, function] {
+            promise->addResult(function());
+            promise->finish();
+        },
+        Qt::QueuedConnection);
+}
+
+void JSONAdapter::handleMessage(const QByteArray &message)
+{
+    QJsonObject object;
+
+    if (_format == Cbor) {
+        QCborParserError error;
+        const auto value = QCborValue::fromCbor(message, &error);
+
+        if (error.error != QCborError::NoError) {
+            qCWarning(self) << "parse error" << error.errorString() << "in" << message.toHex();
+            return;
+        }
+
+        if (!value.isMap()) {
+            qCWarning(self) << "cbor value is not a map:" << value;
+            return;
+        }
+
+        object = value.toMap().toJsonObject();
+    } else {
+        QJsonParseError error;
+        auto doc = QJsonDocument::fromJson(message, &error);
+
+        if (error.error != QJsonParseError::NoError) {
+            qCWarning(self) << "parse error" << error.errorString() << "in" << message;
+            return;
+        }
+
+        if (!doc.isObject()) {
+            qCWarning(self) << "json doc is not an object:" << doc;
+            return;
+        }
+
+        object = doc.object();
+    }
 
     if (!object["type"].isString()) {
         qCWarning(self) << "no type attribute in object!";
@@ -49,79 +344,422 @@ void JSONAdapter::handleMessage(const QByteArray &message)
 
     auto key = object["key"].toString();
 
+    // requests may carry an id of the client's choice, their return has the same id.
+    // returns can arrive out of order, calls of other threads finish when they finish
+    auto id = object.value("id");
+
     if (type == "call")
-        handleCall(key, object["args"].toArray());
+        handleCall(key, object["args"].toArray(), id);
     else if (type == "get")
-        handleGet(key);
+        handleGet(key, id);
+    else if (type == "snapshot")
+        handleSnapshot(key);
     else if (type == "set")
         handleSet(key, object["value"]);
+    else if (type == "batch")
+        handleBatch(key, object["value"].toObject(), object["atomic"].toBool(), id);
     else if (type == "subscribe")
         handleSubscribe(key);
+    else if (type == "unsubscribe")
+        handleUnsubscribe(key);
+    else if (type == "session")
+        handleSession();
+    else if (type == "resume")
+        handleResume(key, quint64(object["value"].toInteger()));
     else
         qCCritical(self) << "invalid type:" << type << key;
 }
 
-void JSONAdapter::onValueChanged(const QString &key, const QVariant &value)
+
+void JSONAdapter::onValueChanged(const QString &key, const QVariant &value, quint64 version)
 {
-    if (_subscribed[key] == 0)
+    if (_subscribed.value(key) == 0)
         return;
 
+    // the version identifies a change only if the key got one for it
+    sendNotify(key, value, version, QObjectRegistry::isVersioned(key));
+}
+
+void JSONAdapter::onListChanged(const QString &key, const QVariantList &deltas)
+{
+    if (_subscribed.value(key) == 0)
+        return;
+
+    const auto stats = statsOf(key);
+    RegistryStats::Measurement measurement{stats.get(), RegistryStats::Send};
+    QJsonArray changes;
+
+    for (const auto &delta : deltas) {
+        const auto map = delta.toMap();
+        QJsonObject change;
+
+        for (auto it = map.cbegin(); it != map.cend(); ++it)
+            change[it.key()] = JSON::serialize(it.value());
+
+        changes.append(change);
+    }
+
     QJsonObject object{
-        {"type", "notify"},
+        {"type", "delta"},
         {"key", key},
-        {"value", JSON::serialize(value)},
+        {"changes", changes},
     };
 
-    qCDebug(self) << "send notify" << object;
-    emit sendMessage(QJsonDocument{object}.toJson());
+    qCDebug(self) << "send delta" << object;
+    send(object);
 }
 
-void JSONAdapter::handleSubscribe(const QString &key)
+void JSONAdapter::onSignalEmitted(const QString &key, const QVariantList &args)
 {
-    qCInfo(self) << "subscribed to key:" << key;
-    _subscribed[key] += 1;
+    if (_subscribed.value(key) == 0)
+        return;
 
-    auto value = _registry.get(key);
+    const auto stats = statsOf(key);
+    RegistryStats::Measurement measurement{stats.get(), RegistryStats::Send};
+    QJsonArray array;
+    for (const auto &arg : args)
+        array.append(JSON::serialize(arg));
 
     QJsonObject object{
-        {"type", "notify"},
-        {"value", JSON::serialize(value)},
+        {"type", "signal"},
         {"key", key},
+        {"args", array},
     };
 
-    emit sendMessage(QJsonDocument{object}.toJson());
+    qCDebug(self) << "send signal" << object;
+    send(object);
 }
 
-void JSONAdapter::handleCall(const QString &key, const QJsonArray &array)
+
+void JSONAdapter::handleSubscribe(const QString &key)
 {
-    qCInfo(self) << "calling" << key << array;
-    auto returnValue = _registry.call(key, array.toVariantList());
+    qCInfo(self) << "subscribed to key:" << key;
 
-    QJsonObject object{
-        {"type", "return"},
-        {"value", JSON::serialize(returnValue)},
-        {"key", key},
-    };
+    const auto first = _subscribed[key]++ == 0;
+
+    request(
+        [registry = &_registry, link = QPointer<RegistryLink>{_link}, key, first] {
+            if (first)
+                registry->subscribe(key);
 
-    emit sendMessage(QJsonDocument{object}.toJson());
+            if (first && link)
+                link->subscribe(key);
+
+            // signals have no value to start with
+            if (registry->isSignal(key))
+                return QList<Reading>{};
+
+            return QList<Reading>{Reading{key, RegistryLink::detach(registry->get(key)), registry->version()}};
+        },
+        [this](const QList<Reading> &readings) {
+            for (const auto &reading : readings)
+                sendNotify(reading.key, reading.value, reading.version);
+        });
+}
+
+void JSONAdapter::handleUnsubscribe(const QString &key)
+{
+    qCInfo(self) << "unsubscribed from key:" << key;
+
+    auto it = _subscribed.find(key);
+
+    if (it == _subscribed.end() || *it == 0) {
+        qCWarning(self) << "not subscribed to key:" << key;
+        return;
+    }
+
+    if (--(*it) == 0) {
+        _subscribed.erase(it);
+        _keyStats.remove(key);
+        post([registry = &_registry, link = QPointer<RegistryLink>{_link}, key] {
+            registry->unsubscribe(key);
+
+            if (link)
+                link->unsubscribe(key);
+        });
+    }
+}
+
+void JSONAdapter::handleCall(const QString &key, const QJsonArray &array, const QJsonValue &id)
+{
+    qCInfo(self) << "calling" << key << array << id;
+
+    request(
+        [registry = &_registry, key, arguments = array.toVariantList(), linked = _link != nullptr] {
+            auto future = registry->callAsync(key, arguments);
+
+            // returned objects are serialized in the registry thread as well
+            return linked ? future.then(registry, &RegistryLink::detach) : future;
+        },
+        [this, key, id](QFuture<QVariant> future) {
+            if (future.isFinished() && future.resultCount() > 0) {
+                sendReturn(key, JSON::serialize(future.result()), id);
+                return;
+            }
+
+            // calls of other threads, pooled calls and methods returning futures answer once they finished
+            future.then(this, [this, key, id](const QVariant &value) { sendReturn(key, JSON::serialize(value), id); })
+                .onFailed(this, [this, key, id] { sendReturn(key, QJsonValue::Null, id); })
+                .onCanceled(this, [this, key, id] { sendReturn(key, QJsonValue::Null, id); });
+        });
 }
 
 void JSONAdapter::handleSet(const QString &key, const QJsonValue &value)
 {
     qCDebug(self) << "handle set" << key << value;
-    _registry.set(key, value);
+
+    // straight into the property type, values that do not fit leave the property as it is
+    post([registry = &_registry, key, value] {
+        const auto variant = setValue(value, registry->typeOf(key));
+
+        if (variant.isValid())
+            registry->set(key, variant);
+    });
 }
 
-void JSONAdapter::handleGet(const QString &key)
+void JSONAdapter::handleBatch(const QString &prefix, const QJsonObject &values, bool atomic, const QJsonValue &id)
 {
-    auto value = _registry.get(key);
+    qCDebug(self) << "handle batch" << prefix << values.size() << atomic;
+
+    request(
+        [registry = &_registry, prefix, values, atomic] {
+            // keys of the batch are relative to the message key, an empty key makes them absolute
+
+            // values that do not fit fail the batch, an atomic one before anything is written
+
+            QVariantMap variants;
+            bool ok = true;
+
+            for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
+                const auto key = prefix.isEmpty() ? it.key() : QString{"%1.%2"}.arg(prefix, it.key());
+                const auto variant = setValue(it.value(), registry->typeOf(key));
+
+                if (variant.isValid())
+                    variants.insert(key, variant);
+                else if (atomic)
+                    return false;
+                else
+                    ok = false;
+            }
+
+            return registry->setBatch(variants, atomic) && ok;
+        },
+        [this, prefix, id](bool ok) { sendReturn(prefix, ok, id); });
+}
+
+void JSONAdapter::handleGet(const QString &key, const QJsonValue &id)
+{
+    qCDebug(self) << "handle get" << key << id;
+
+    request([registry = &_registry, key] { return RegistryLink::detach(registry->get(key)); },
+            [this, key, id](const QVariant &value) { sendReturn(key, JSON::serialize(value), id); });
+}
+
+void JSONAdapter::handleSnapshot(const QString &pattern)
+{
+    // snapshots leave out object valued keys, there is nothing to detach
+    request([registry = &_registry, pattern] { return registry->snapshot(pattern); },
+            [this, pattern](const QVariantMap &values) {
+                QJsonObject object;
+                for (auto it = values.cbegin(); it != values.cend(); ++it)
+                    object[it.key()] = JSON::serialize(it.value());
+
+                qCDebug(self) << "handle snapshot" << pattern << values.size();
+                send(QJsonObject{
+                    {"type", "snapshot"},
+                    {"key", pattern},
+                    {"value", object},
+                });
+            });
+}
+
+void JSONAdapter::handleSession()
+{
+    if (_session.isEmpty())
+        _session = QUuid::createUuid().toString(QUuid::WithoutBraces);
+
+    request([registry = &_registry] { return registry->version(); },
+            [this](quint64 version) {
+                QJsonObject object{
+                    {"type", "session"},
+                    {"key", _session},
+                    {"value", qint64(version)},
+                };
+
+                qCInfo(self) << "session" << _session;
+                send(object);
+            });
+}
+
+void JSONAdapter::handleResume(const QString &session, quint64 version)
+{
+    std::unique_ptr<Session> cached;
+
+    {
+        QMutexLocker locker{&sessionsMutex()};
+        cached.reset(sessions().take(session));
+    }
+
+    if (!cached || cached->expiry.hasExpired()) {
+        qCWarning(self) << "unknown session:" << session;
+        handleSession();
+        return;
+    }
+
+    qCInfo(self) << "resume session" << session << "from version" << version;
+    _session = session;
+
+    // we take over the subscriptions of the session, the ones we hold already are one too many
+    const auto keys = std::exchange(cached->keys, {});
+    cached.reset();
+
+    QStringList release;
+    QStringList linked;
+    for (const auto &key : keys)
+        (_subscribed[key]++ > 0 ? release : linked).append(key);
+
+    QSet<QString> subscribed;
+    for (auto it = _subscribed.cbegin(); it != _subscribed.cend(); ++it)
+        if (*it > 0)
+            subscribed.insert(it.key());
+
+    request(
+        [registry = &_registry, link = QPointer<RegistryLink>{_link}, keys, release, linked, subscribed, version] {
+            for (const auto &key : release)
+                registry->unsubscribe(key);
+
+            if (link)
+                for (const auto &key : linked)
+                    link->subscribe(key);
+
+            // only what changed since the client's last version, everything if the journal lost track
+
+            bool complete;
+            const auto changes = registry->changesSince(version, &complete);
+            QList<Reading> readings;
+
+            if (complete) {
+                for (const auto &change : changes) {
+                    if (!subscribed.contains(change.key))
+                        continue;
+
+                    // values referencing objects are not journaled, they are read as they are now
+                    const auto value = change.value.isValid() ? change.value : registry->get(change.key);
+                    readings.append(Reading{change.key, RegistryLink::detach(value), registry->version()});
+                }
+            } else {
+                for (const auto &key : keys)
+                    if (!registry->isSignal(key))
+                        readings.append(Reading{key, RegistryLink::detach(registry->get(key)), registry->version()});
+            }
+
+            return readings;
+        },
+        [this](const QList<Reading> &readings) {
+            for (const auto &reading : readings)
+                if (_subscribed.value(reading.key) > 0)
+                    sendNotify(reading.key, reading.value, reading.version);
+
+            handleSession();
+        });
+}
+
+std::shared_ptr<RegistryStats::KeyStats> JSONAdapter::statsOf(const QString &key)
+{
+    // subscribed keys keep their stats, so only their first send takes the lock. the registry
+    // releases the stats of deregistered keys, those are tracked again once they are back
+    if (!_registry.stats().isEnabled())
+        return nullptr;
+
+    if (_subscribed.value(key) == 0)
+        return _registry.stats().track(key);
+
+    auto &stats = _keyStats[key];
+
+    if (stats == nullptr || stats->released.load(std::memory_order_relaxed))
+        stats = _registry.stats().track(key);
+
+    return stats;
+}
+
+void JSONAdapter::sendReturn(const QString &key, const QJsonValue &value, const QJsonValue &id)
+{
+    const auto stats = statsOf(key);
+    RegistryStats::Measurement measurement{stats.get(), RegistryStats::Send};
 
     QJsonObject object{
         {"type", "return"},
-        {"value", JSON::serialize(value)},
+        {"value", value},
+        {"key", key},
+    };
+
+    if (!id.isUndefined())
+        object["id"] = id;
+
+    send(object);
+}
+
+void JSONAdapter::sendNotify(const QString &key, const QVariant &value, quint64 version, bool broadcast)
+{
+    const auto stats = statsOf(key);
+    RegistryStats::Measurement measurement{stats.get(), RegistryStats::Send};
+
+    // most notifies carry a number, those are written straight into the frame
+    QByteArray frame;
+    frame.reserve(64 + key.size());
+
+    if (_format == Cbor ? writeCborNotify(frame, key, value, version) : writeJsonNotify(frame, key, value, version)) {
+        qCDebug(self) << "send notify" << key << value;
+        emit sendMessage(frame, key);
+        return;
+    }
+
+    // everything else is encoded once per change and format. the version identifies the change,
+    // other notifies may read a value that changed without a version of its own
+    auto &cache = frameCache();
+    const FrameKey frameKey{&_registry, _format, key};
+
+    if (broadcast) {
+        QMutexLocker locker{&cache.mutex};
+        const auto cached = cache.frames.object(frameKey);
+
+        if (cached && cached->version == version) {
+            frame = cached->data;
+            locker.unlock();
+
+            qCDebug(self) << "send shared notify" << key << version;
+            emit sendMessage(frame, key);
+            return;
+        }
+    }
+
+    QJsonObject object{
+        {"type", "notify"},
         {"key", key},
+        {"value", JSON::serialize(value)},
+        {"version", qint64(version)},
     };
 
-    qCDebug(self) << "handle get" << object;
-    emit sendMessage(QJsonDocument{object}.toJson());
+    qCDebug(self) << "send notify" << object;
+    frame = encode(object);
+
+    if (broadcast) {
+        QMutexLocker locker{&cache.mutex};
+        cache.frames.insert(frameKey, new Frame{version, frame}, frame.size());
+    }
+
+    emit sendMessage(frame, key);
+}
+
+void JSONAdapter::send(const QJsonObject &object)
+{
+    emit sendMessage(encode(object));
+}
+
+QByteArray JSONAdapter::encode(const QJsonObject &object) const
+{
+    if (_format == Cbor)
+        return QCborMap::fromJsonObject(object).toCborValue().toCbor();
+
+    return QJsonDocument{object}.toJson();
 }
@@ -1,34 +1,80 @@
 #ifndef JSONADAPTER_H
 #define JSONADAPTER_H
 
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonValue>
 #include <QObject>
 
 #include "qobjectregistry.h"
 
+class RegistryLink;
+
+/*
+ * speaks the json protocol for one client. an adapter created in another thread than
+ * the registry's does its parsing and encoding there and never touches the registry:
+ * requests are queued to the registry thread, results and changes come back queued.
+ * the same messages can go as cbor instead of json text, e.g. for binary websocket frames.
+ */
 class JSONAdapter : public QObject
 {
     Q_OBJECT
 public:
+    enum Format {
+        Json,
+        Cbor,
+    };
+
     explicit JSONAdapter(QObjectRegistry &registry, QObject *parent = nullptr);
+    JSONAdapter(QObjectRegistry &registry, Format format, QObject *parent = nullptr);
+    ~JSONAdapter();
+
+    Format format() const;
     //static QJsonValue serialize(const QVariant &variant);
 
 public slots:
     void handleMessage(const QByteArray &message);
 
 signals:
-    void sendMessage(const QByteArray &message);
+    // notifies pass their key, a newer notify of the same key supersedes them while they wait
+    void sendMessage(const QByteArray &message, const QString &key = QString());
 
 private slots:
-    void onValueChanged(const QString &key, const QVariant &value);
+    void onValueChanged(const QString &key, const QVariant &value, quint64 version);
+    void onListChanged(const QString &key, const QVariantList &deltas);
+    void onSignalEmitted(const QString &key, const QVariantList &args);
 
     void handleSubscribe(const QString &key);
-    void handleCall(const QString &key, const QJsonArray &array);
+    void handleUnsubscribe(const QString &key);
+    void handleCall(const QString &key, const QJsonArray &array, const QJsonValue &id);
     void handleSet(const QString &key, const QJsonValue &array);
-    void handleGet(const QString &key);
+    void handleBatch(const QString &prefix, const QJsonObject &values, bool atomic, const QJsonValue &id);
+    void handleGet(const QString &key, const QJsonValue &id);
+    void handleSnapshot(const QString &pattern);
+    void handleSession();
+    void handleResume(const QString &session, quint64 version);
 
 private:
+    // runs function with the registry, in its thread. done gets the result in ours
+    template<class Function>
+    void post(Function function);
+    template<class Function, class Done>
+    void request(Function function, Done done);
+
+    std::shared_ptr<RegistryStats::KeyStats> statsOf(const QString &key);
+    void sendReturn(const QString &key, const QJsonValue &value, const QJsonValue &id);
+    // broadcast notifies are the same for every subscriber of a change, their frames are shared
+    void sendNotify(const QString &key, const QVariant &value, quint64 version, bool broadcast = false);
+    void send(const QJsonObject &object);
+    QByteArray encode(const QJsonObject &object) const;
+
+    QString _session;
     QMap<QString, int> _subscribed;
+    // of subscribed keys, the rest is looked up per send
+    QHash<QString, std::shared_ptr<RegistryStats::KeyStats>> _keyStats;
     QObjectRegistry &_registry;
+    RegistryLink *_link;
+    Format _format;
 };
 
 #endif // JSONADAPTER_H
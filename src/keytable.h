@@ -0,0 +1,277 @@
+#ifndef KEYTABLE_H
+#define KEYTABLE_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+/*
+ * interns dotted keys like "b.as.0.string" into small integer ids and keeps
+ * one value per id. the keys are additionally stored as a trie of path segments,
+ * so removing or enumerating everything below "b.as" only visits that subtree.
+ * the values are kept apart from the trie in one flat array indexed by id, so
+ * looking up a value by id only touches the value itself.
+ *
+ * a prefix without trailing dot ("b.as") addresses the node and its children,
+ * a prefix with trailing dot ("b.as.") only the children, an empty prefix
+ * addresses every key.
+ */
+template<class T>
+class KeyTable
+{
+public:
+    KeyTable();
+
+    int insert(const QString &key);
+    int find(const QString &key) const;
+
+    bool contains(int id) const;
+    const QString &key(int id) const;
+
+    T &operator[](int id);
+    const T &operator[](int id) const;
+
+    template<class Visitor>
+    void forEach(const QString &prefix, Visitor visit) const;
+
+    template<class Visitor>
+    void remove(const QString &prefix, Visitor visit);
+    void remove(const QString &prefix);
+
+    QStringList keys(const QString &prefix = QString()) const;
+    int size() const;
+
+private:
+    struct Node
+    {
+        QString key;
+        int parent = -1;
+        bool occupied = false;
+        QHash<QString, int> children;
+    };
+
+    int node(const QString &key);
+    int subtreeRoot(const QString &prefix, bool *withRoot) const;
+    void release(int id);
+    void prune(int id);
+
+    QList<Node> _nodes;
+    QList<T> _values;
+    QList<int> _free;
+    QHash<QString, int> _index;
+    int _size;
+};
+
+template<class T>
+inline KeyTable<T>::KeyTable()
+    : _nodes{Node{}}
+    , _values{T{}}
+    , _size{0}
+{}
+
+template<class T>
+inline int KeyTable<T>::insert(const QString &key)
+{
+    Q_ASSERT(!key.isEmpty());
+
+    const auto id = node(key);
+
+    if (!_nodes[id].occupied) {
+        _nodes[id].occupied = true;
+        _size++;
+    }
+
+    return id;
+}
+
+template<class T>
+inline int KeyTable<T>::find(const QString &key) const
+{
+    const auto it = _index.constFind(key);
+
+    if (it == _index.cend() || !_nodes[*it].occupied)
+        return -1;
+
+    return *it;
+}
+
+template<class T>
+inline bool KeyTable<T>::contains(int id) const
+{
+    return id > 0 && id < _nodes.size() && _nodes[id].occupied;
+}
+
+template<class T>
+inline const QString &KeyTable<T>::key(int id) const
+{
+    return _nodes[id].key;
+}
+
+template<class T>
+inline T &KeyTable<T>::operator[](int id)
+{
+    return _values[id];
+}
+
+template<class T>
+inline const T &KeyTable<T>::operator[](int id) const
+{
+    return _values[id];
+}
+
+template<class T>
+template<class Visitor>
+inline void KeyTable<T>::forEach(const QString &prefix, Visitor visit) const
+{
+    bool withRoot;
+    const auto root = subtreeRoot(prefix, &withRoot);
+
+    if (root < 0)
+        return;
+
+    QList<int> stack{root};
+
+    while (!stack.isEmpty()) {
+        const auto id = stack.takeLast();
+        const auto &node = _nodes[id];
+
+        if (node.occupied && (id != root || withRoot))
+            visit(id, _values[id]);
+
+        for (auto it = node.children.cbegin(); it != node.children.cend(); ++it)
+            stack.append(*it);
+    }
+}
+
+template<class T>
+template<class Visitor>
+inline void KeyTable<T>::remove(const QString &prefix, Visitor visit)
+{
+    bool withRoot;
+    const auto root = subtreeRoot(prefix, &withRoot);
+
+    if (root < 0)
+        return;
+
+    QList<int> stack;
+
+    for (auto it = _nodes[root].children.cbegin(); it != _nodes[root].children.cend(); ++it)
+        stack.append(*it);
+
+    _nodes[root].children.clear();
+
+    while (!stack.isEmpty()) {
+        const auto id = stack.takeLast();
+
+        for (auto it = _nodes[id].children.cbegin(); it != _nodes[id].children.cend(); ++it)
+            stack.append(*it);
+
+        if (_nodes[id].occupied)
+            visit(id, _values[id]);
+
+        release(id);
+    }
+
+    if (withRoot && _nodes[root].occupied) {
+        visit(root, _values[root]);
+        _nodes[root].occupied = false;
+        _values[root] = T{};
+        _size--;
+    }
+
+    prune(root);
+}
+
+template<class T>
+inline void KeyTable<T>::remove(const QString &prefix)
+{
+    remove(prefix, [](int, const T &) {});
+}
+
+template<class T>
+inline QStringList KeyTable<T>::keys(const QString &prefix) const
+{
+    QStringList keys;
+    forEach(prefix, [this, &keys](int id, const T &) { keys.append(_nodes[id].key); });
+    return keys;
+}
+
+template<class T>
+inline int KeyTable<T>::size() const
+{
+    return _size;
+}
+
+template<class T>
+inline int KeyTable<T>::node(const QString &key)
+{
+    const auto it = _index.constFind(key);
+
+    if (it != _index.cend())
+        return *it;
+
+    // create all missing parents first, a key always hangs below its parent path
+
+    const auto separator = key.lastIndexOf(u'.');
+    const auto parent = separator < 0 ? 0 : node(key.left(separator));
+
+    int id;
+
+    if (_free.isEmpty()) {
+        id = _nodes.size();
+        _nodes.append(Node{});
+        _values.append(T{});
+    } else {
+        id = _free.takeLast();
+    }
+
+    _nodes[id].key = key;
+    _nodes[id].parent = parent;
+    _nodes[parent].children.insert(key.mid(separator + 1), id);
+    _index.insert(key, id);
+
+    return id;
+}
+
+template<class T>
+inline int KeyTable<T>::subtreeRoot(const QString &prefix, bool *withRoot) const
+{
+    *withRoot = !prefix.isEmpty() && !prefix.endsWith(u'.');
+
+    if (prefix.isEmpty())
+        return 0;
+
+    const auto it = _index.constFind(*withRoot ? prefix : prefix.chopped(1));
+    return it == _index.cend() ? -1 : *it;
+}
+
+template<class T>
+inline void KeyTable<T>::release(int id)
+{
+    if (_nodes[id].occupied)
+        _size--;
+
+    _index.remove(_nodes[id].key);
+    _nodes[id] = Node{};
+    _values[id] = T{};
+    _free.append(id);
+}
+
+template<class T>
+inline void KeyTable<T>::prune(int id)
+{
+    // drop intermediate nodes that neither hold a value nor lead to one anymore
+
+    while (id > 0 && !_nodes[id].occupied && _nodes[id].children.isEmpty()) {
+        const auto parent = _nodes[id].parent;
+        const auto &key = _nodes[id].key;
+
+        _nodes[parent].children.remove(key.mid(key.lastIndexOf(u'.') + 1));
+        release(id);
+
+        id = parent;
+    }
+}
+
+#endif // KEYTABLE_H
@@ -0,0 +1,113 @@
+#include "methodinvoker.h"
+
+#include <QLoggingCategory>
+#include <QVarLengthArray>
+
+namespace {
+Q_LOGGING_CATEGORY(self, "invoker", QtWarningMsg)
+
+// most slots take only a few arguments, these stay on the stack
+constexpr int PreallocatedArguments = 8;
+} // namespace
+
+MethodInvoker::MethodInvoker(const QMetaMethod &method)
+    : _method{method}
+    , _returnType{method.returnMetaType()}
+    , _concurrent{qstrcmp(method.tag(), "QOPENREMOTE_CONCURRENT") == 0}
+{
+    _parameterTypes.reserve(method.parameterCount());
+
+    for (int i = 0; i < method.parameterCount(); ++i)
+        _parameterTypes.append(method.parameterMetaType(i));
+}
+
+bool MethodInvoker::isValid() const
+{
+    return _method.isValid();
+}
+
+bool MethodInvoker::isConcurrent() const
+{
+    return _concurrent;
+}
+
+int MethodInvoker::parameterCount() const
+{
+    return _parameterTypes.size();
+}
+
+const QMetaMethod &MethodInvoker::method() const
+{
+    return _method;
+}
+
+QVariant MethodInvoker::invoke(QObject *object, const QVariantList &arguments, bool *ok) const
+{
+    if (ok)
+        *ok = false;
+
+    if (arguments.size() != _parameterTypes.size()) {
+        qCCritical(self) << "invalid arg size:" << _parameterTypes.size() << arguments.size();
+        return QVariant{};
+    }
+
+    // argv[0] is the return value, followed by pointers to the arguments. arguments that
+    // already have the right type are passed in place, the others get converted into storage
+
+    QVarLengthArray<void *, PreallocatedArguments + 1> argv(arguments.size() + 1);
+    QVarLengthArray<QVariant, PreallocatedArguments> storage(arguments.size());
+
+    for (int i = 0; i < arguments.size(); ++i) {
+        const auto &argument = arguments[i];
+        const auto &parameterType = _parameterTypes[i];
+
+        if (parameterType.id() == QMetaType::QVariant) {
+            argv[i + 1] = const_cast<QVariant *>(&argument);
+            continue;
+        }
+
+        if (argument.metaType() == parameterType) {
+            argv[i + 1] = const_cast<void *>(argument.constData());
+            continue;
+        }
+
+        storage[i] = QVariant{parameterType};
+        argv[i + 1] = storage[i].data();
+
+        if (!argument.isValid())
+            continue;
+
+        if (!QMetaType::convert(argument.metaType(), argument.constData(), parameterType, argv[i + 1])) {
+            qCCritical(self) << "cannot convert" << argument << "to" << parameterType.name() << "for" << _method.methodSignature();
+            return QVariant{};
+        }
+    }
+
+    QVariant returnValue;
+
+    if (_returnType.id() == QMetaType::Void)
+        argv[0] = nullptr;
+    else if (_returnType.id() == QMetaType::QVariant)
+        argv[0] = &returnValue;
+    else {
+        returnValue = QVariant{_returnType};
+        argv[0] = returnValue.data();
+    }
+
+    try {
+        if (QMetaObject::metacall(object, QMetaObject::InvokeMetaMethod, _method.methodIndex(), argv.data()) >= 0) {
+            qCWarning(self) << "calling" << _method.methodSignature() << "failed.";
+            return QVariant{};
+        }
+    }
+
+    catch (const std::exception &error) {
+        qCCritical(self) << "invoking method threw error:" << QString(error.what());
+        return QVariant{};
+    }
+
+    if (ok)
+        *ok = true;
+
+    return returnValue;
+}
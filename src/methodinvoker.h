@@ -0,0 +1,27 @@
+#ifndef METHODINVOKER_H
+#define METHODINVOKER_H
+
+#include <QMetaMethod>
+#include <QVariant>
+
+class MethodInvoker
+{
+public:
+    MethodInvoker() = default;
+    explicit MethodInvoker(const QMetaMethod &method);
+
+    bool isValid() const;
+    bool isConcurrent() const;
+    int parameterCount() const;
+    const QMetaMethod &method() const;
+
+    QVariant invoke(QObject *object, const QVariantList &arguments, bool *ok = nullptr) const;
+
+private:
+    QMetaMethod _method;
+    QList<QMetaType> _parameterTypes;
+    QMetaType _returnType;
+    bool _concurrent;
+};
+
+#endif // METHODINVOKER_H
@@ -0,0 +1,65 @@
+#include "objectmirror.h"
+
+#include <QLoggingCategory>
+#include <QSet>
+#include <QThread>
+
+#include "signalrelay.h"
+
+namespace {
+Q_LOGGING_CATEGORY(self, "mirror", QtWarningMsg)
+}
+
+ObjectMirror::ObjectMirror(QObject *object, const std::shared_ptr<const ClassDescriptor> &descriptor)
+    : _object{object}
+    , _descriptor{descriptor}
+    , _relay{new SignalRelay{[this](int signal, const QVariantList &) { readProperties(_descriptor->propertiesNotifiedBy(signal)); }, this}}
+{
+    QSet<int> notifySignals;
+
+    for (const auto &property : descriptor->properties())
+        if (property.notifySignal >= 0)
+            notifySignals.insert(property.notifySignal);
+
+    // the object may emit in its thread while we are still connecting, so no reallocations below
+    _relay->reserve(int(notifySignals.size()));
+
+    for (const auto signal : std::as_const(notifySignals))
+        _relay->connectSignal(object, descriptor->metaObject()->method(signal), signal, Qt::DirectConnection);
+}
+
+void ObjectMirror::start()
+{
+    qCDebug(self) << "mirror" << _object << "in" << _object->thread();
+    moveToThread(_object->thread());
+
+    QMetaObject::invokeMethod(
+        this,
+        [this] {
+            if (_object.isNull())
+                return;
+
+            QList<int> properties;
+
+            for (int i = 0; i < _descriptor->properties().size(); ++i)
+                if (_descriptor->properties()[i].property.isReadable())
+                    properties.append(i);
+
+            readProperties(properties);
+        },
+        Qt::QueuedConnection);
+}
+
+void ObjectMirror::readProperties(const QList<int> &properties)
+{
+    if (_object.isNull())
+        return;
+
+    QVariantList values;
+    values.reserve(properties.size());
+
+    for (const auto property : properties)
+        values.append(_descriptor->properties()[property].property.read(_object));
+
+    emit valuesRead(_object.data(), properties, values);
+}
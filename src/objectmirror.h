@@ -0,0 +1,39 @@
+#ifndef OBJECTMIRROR_H
+#define OBJECTMIRROR_H
+
+#include <QObject>
+#include <QPointer>
+#include <QVariant>
+
+#include "classdescriptor.h"
+
+class SignalRelay;
+
+/*
+ * reads the properties of an object in the thread the object lives in, whenever one
+ * of their notify signals fires, and reports the values with a queued signal. this
+ * way the registry never touches objects of other threads and never waits for them.
+ */
+class ObjectMirror : public QObject
+{
+    Q_OBJECT
+public:
+    ObjectMirror(QObject *object, const std::shared_ptr<const ClassDescriptor> &descriptor);
+
+    // moves over to the thread of the object and reports every readable property once
+    void start();
+
+signals:
+    void valuesRead(QObject *object, const QList<int> &properties, const QVariantList &values);
+
+private:
+    void readProperties(const QList<int> &properties);
+
+    // only ever dereferenced in the thread of the object, where it cannot go away meanwhile
+    QPointer<QObject> _object;
+    // shared with the registry, which may let go of a dynamic one before we are deleted
+    std::shared_ptr<const ClassDescriptor> _descriptor;
+    SignalRelay *_relay;
+};
+
+#endif // OBJECTMIRROR_H
@@ -0,0 +1,221 @@
+#include "outboundqueue.h"
+
+#include <QCborStreamWriter>
+#include <QLoggingCategory>
+#include <QtWebSockets/QWebSocket>
+
+namespace {
+Q_LOGGING_CATEGORY(self, "server.queue", QtWarningMsg)
+
+// what the socket may have pending before frames wait in the queue, enough to keep a fast link busy
+constexpr qint64 WriteWatermark = 64 * 1024;
+} // namespace
+
+OutboundQueue::OutboundQueue(QWebSocket *socket, bool binary, const Budget &budget, RegistryStats *stats, const QString &statsKey)
+    : QObject{socket}
+    , _socket{socket}
+    , _binary{binary}
+    , _budget{budget}
+    , _stats{stats}
+    , _statsKey{statsKey}
+    , _first{0}
+    , _depth{0}
+    , _size{0}
+    , _window{-1}
+{
+    connect(_socket, &QWebSocket::bytesWritten, this, &OutboundQueue::onBytesWritten);
+
+    _deadline.setSingleShot(true);
+    _deadline.setInterval(_budget.deadline);
+    connect(&_deadline, &QTimer::timeout, this, &OutboundQueue::onDeadline);
+
+    _coalesce.setSingleShot(true);
+    _coalesce.setTimerType(Qt::PreciseTimer);
+    connect(&_coalesce, &QTimer::timeout, this, &OutboundQueue::flush);
+}
+
+OutboundQueue::~OutboundQueue()
+{
+    account(-_depth, -_size);
+}
+
+int OutboundQueue::depth() const
+{
+    return _depth;
+}
+
+qint64 OutboundQueue::size() const
+{
+    return _size;
+}
+
+void OutboundQueue::setCoalescing(int window)
+{
+    // timers count msecs, a window of usecs rounds up. zero fires with the next event loop iteration
+    _window = window;
+    _coalesce.setInterval(window < 0 ? 0 : (window + 999) / 1000);
+}
+
+int OutboundQueue::coalescing() const
+{
+    return _window;
+}
+
+void OutboundQueue::send(const QByteArray &message, const QString &key)
+{
+    if (_window < 0 && _frames.empty() && _socket->bytesToWrite() < WriteWatermark) {
+        write(message);
+        return;
+    }
+
+    // last value wins, the superseded frame stays behind as a hole so positions keep valid
+    if (!key.isEmpty()) {
+        if (const auto it = _notifies.constFind(key); it != _notifies.cend()) {
+            auto &superseded = _frames[*it - _first];
+            account(-1, -superseded.data.size());
+            superseded = {};
+        }
+
+        _notifies.insert(key, _first + qint64(_frames.size()));
+    }
+
+    _frames.push_back({message, key});
+    account(1, message.size());
+
+    if (qsizetype(_frames.size()) > 2 * _depth + 64)
+        compact();
+
+    if (_window >= 0 && !_coalesce.isActive())
+        _coalesce.start();
+
+    const auto over = _depth > _budget.messages || _size > _budget.bytes;
+
+    if (over && !_deadline.isActive()) {
+        qCWarning(self) << "client over budget" << _socket << _depth << "messages" << _size << "bytes";
+        _deadline.start();
+    } else if (!over) {
+        _deadline.stop();
+    }
+}
+
+void OutboundQueue::flush()
+{
+    // a batch fills up to what the socket may have pending, the rest follows once it is written
+    QList<QByteArray> batch;
+    qint64 batched = 0;
+
+    while (!_frames.empty() && _socket->bytesToWrite() + batched < WriteWatermark) {
+        const auto frame = std::move(_frames.front());
+        _frames.pop_front();
+        ++_first;
+
+        if (frame.data.isNull())
+            continue;
+
+        if (!frame.key.isEmpty())
+            _notifies.remove(frame.key);
+
+        account(-1, -frame.data.size());
+
+        if (_window < 0) {
+            write(frame.data);
+        } else {
+            batch.append(frame.data);
+            batched += frame.data.size();
+        }
+    }
+
+    if (!batch.isEmpty())
+        write(pack(batch));
+
+    if (_depth <= _budget.messages && _size <= _budget.bytes)
+        _deadline.stop();
+}
+
+void OutboundQueue::onBytesWritten()
+{
+    // a running window collects the frames until it is over, it flushes them itself
+    if (_window < 0 || !_coalesce.isActive())
+        flush();
+}
+
+void OutboundQueue::onDeadline()
+{
+    qCWarning(self) << "disconnecting client, over budget for" << _budget.deadline << "msecs:" << _socket << _depth << "messages" << _size << "bytes";
+    _socket->abort();
+}
+
+void OutboundQueue::write(const QByteArray &data)
+{
+    if (_binary)
+        _socket->sendBinaryMessage(data);
+    else
+        _socket->sendTextMessage(QString::fromUtf8(data));
+}
+
+QByteArray OutboundQueue::pack(const QList<QByteArray> &messages) const
+{
+    QByteArray frame;
+
+    // the messages are encoded already, only the array around them is written
+    if (_binary) {
+        QCborStreamWriter writer{&frame};
+        writer.startArray(quint64(messages.size()));
+
+        for (const auto &message : messages)
+            frame.append(message);
+
+        return frame;
+    }
+
+    frame.append('[');
+
+    for (const auto &message : messages) {
+        if (frame.size() > 1)
+            frame.append(',');
+
+        frame.append(message);
+    }
+
+    frame.append(']');
+    return frame;
+}
+
+void OutboundQueue::account(int messages, qint64 bytes)
+{
+    _depth += messages;
+    _size += bytes;
+
+    // looked up once stats are enabled, with everything queued up to then
+    if (_keyStats == nullptr && _stats && _stats->isEnabled()) {
+        _keyStats = _stats->track(_statsKey);
+
+        if (_keyStats)
+            _keyStats->queue(_depth, _size);
+        return;
+    }
+
+    if (_keyStats)
+        _keyStats->queue(messages, bytes);
+}
+
+void OutboundQueue::compact()
+{
+    // a key changing fast behind a stalled socket leaves mostly holes
+    std::deque<Frame> frames;
+
+    _first += qint64(_frames.size());
+    _notifies.clear();
+
+    for (auto &frame : _frames) {
+        if (frame.data.isNull())
+            continue;
+
+        if (!frame.key.isEmpty())
+            _notifies.insert(frame.key, _first + qint64(frames.size()));
+
+        frames.push_back(std::move(frame));
+    }
+
+    _frames = std::move(frames);
+}
@@ -0,0 +1,82 @@
+#ifndef OUTBOUNDQUEUE_H
+#define OUTBOUNDQUEUE_H
+
+#include <deque>
+
+#include <QHash>
+#include <QObject>
+#include <QTimer>
+
+#include "registrystats.h"
+
+class QWebSocket;
+
+/*
+ * the frames of one client on their way to its socket. they go straight through while
+ * the socket has little left to write, otherwise they wait here. a waiting notify is
+ * superseded by a newer one of the same key, returns and everything else always go out.
+ * a client that stays over its budget for longer than the deadline is disconnected.
+ * coalescing clients get their messages packed into frames holding arrays of them.
+ */
+class OutboundQueue : public QObject
+{
+    Q_OBJECT
+public:
+    struct Budget
+    {
+        qint64 bytes = 4 * 1024 * 1024;
+        int messages = 10000;
+        int deadline = 5000; // msecs
+    };
+
+    // a child of the socket. the queued frames add to the levels of statsKey once stats are enabled
+    OutboundQueue(QWebSocket *socket, bool binary, const Budget &budget, RegistryStats *stats = nullptr, const QString &statsKey = QString());
+    ~OutboundQueue() override;
+
+    int depth() const;
+    qint64 size() const;
+
+    // -1 sends every message in a frame of its own. otherwise messages wait for the end of the
+    // event loop iteration, or for the window in usecs, and go out together in one frame
+    void setCoalescing(int window);
+    int coalescing() const;
+
+public slots:
+    void send(const QByteArray &message, const QString &key = QString());
+
+private slots:
+    void flush();
+    void onBytesWritten();
+    void onDeadline();
+
+private:
+    struct Frame
+    {
+        QByteArray data; // null once superseded
+        QString key;
+    };
+
+    void write(const QByteArray &data);
+    QByteArray pack(const QList<QByteArray> &messages) const;
+    void account(int messages, qint64 bytes);
+    void compact();
+
+    QWebSocket *_socket;
+    bool _binary;
+    Budget _budget;
+    RegistryStats *_stats;
+    QString _statsKey;
+    std::shared_ptr<RegistryStats::KeyStats> _keyStats;
+
+    // waiting notifies by key, as positions counted from the first frame ever queued
+    std::deque<Frame> _frames;
+    QHash<QString, qint64> _notifies;
+    qint64 _first;
+    int _depth;
+    qint64 _size;
+    QTimer _deadline;
+    int _window;
+    QTimer _coalesce;
+};
+
+#endif // OUTBOUNDQUEUE_H
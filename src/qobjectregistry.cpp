@@ -1,145 +1,723 @@
 #include "qobjectregistry.h"
 
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <utility>
 #include <vector>
 
 #include <QLoggingCategory>
+#include <QPromise>
+#include <QRegularExpression>
+#include <QThread>
+#include <QThreadPool>
 
 namespace {
 Q_LOGGING_CATEGORY(self, "registry", QtWarningMsg)
+
+// stats are read only keys below this prefix, subscribers get them once per interval
+constexpr QLatin1String StatsPrefix{"__stats."};
+constexpr int StatsInterval = 1000;
+
+using Promise = std::shared_ptr<QPromise<QVariant>>;
+
+// a result that is a future itself fulfills the promise once it finished
+void fulfill(const Promise &promise, const QVariant &result)
+{
+    static const auto futureType = QMetaType::fromType<QFuture<QVariant>>();
+
+    if (result.metaType() == futureType || (result.isValid() && QMetaType::canConvert(result.metaType(), futureType))) {
+        result.value<QFuture<QVariant>>().then([promise](const QVariant &value) {
+            promise->addResult(value);
+            promise->finish();
+        });
+        return;
+    }
+
+    if (QByteArray{result.metaType().name()}.startsWith("QFuture<"))
+        qCWarning(self) << "no conversion for" << result.metaType().name() << "registered, see QObjectRegistry::registerFutureType()";
+
+    promise->addResult(result);
+    promise->finish();
+}
+
+// the property call of the meta object straight into stack storage, no QVariant of the property type in between
+template<class T>
+QVariant readValue(QObject *object, int index)
+{
+    T value{};
+    int status = -1;
+    void *arguments[] = {&value, nullptr, &status};
+    QMetaObject::metacall(object, QMetaObject::ReadProperty, index, arguments);
+    return QVariant::fromValue(value);
+}
+
+QVariant readProperty(QObject *object, const ClassDescriptor::Property &property)
+{
+    const auto index = property.property.propertyIndex();
+
+    switch (property.type.id()) {
+    case QMetaType::Bool:
+        return readValue<bool>(object, index);
+    case QMetaType::Int:
+        return readValue<int>(object, index);
+    case QMetaType::LongLong:
+        return readValue<qint64>(object, index);
+    case QMetaType::Double:
+        return readValue<double>(object, index);
+    case QMetaType::QString:
+        return readValue<QString>(object, index);
+    default:
+        return property.property.read(object);
+    }
+}
+
+QList<QObject *> objectsOf(const QVariantList &elements)
+{
+    QList<QObject *> objects;
+    objects.reserve(elements.size());
+
+    for (const auto &element : elements)
+        objects.append(element.metaType().flags().testFlag(QMetaType::PointerToQObject) ? element.value<QObject *>() : nullptr);
+
+    return objects;
 }
 
+// the insert, remove and move operations that turn one list of objects into another, in the order they apply
+QVariantList diffObjects(QList<QObject *> from, const QList<QObject *> &to, const QVariantList &values)
+{
+    QVariantList deltas;
+
+    // remove everything the new list has fewer of, back to front so the indexes stay valid
+
+    QHash<QObject *, int> available;
+    for (const auto object : to)
+        available[object]++;
+
+    QList<int> removed;
+    for (int i = 0; i < from.size(); ++i) {
+        auto it = available.find(from[i]);
+
+        if (it != available.end() && *it > 0)
+            --(*it);
+        else
+            removed.append(i);
+    }
+
+    for (auto it = removed.crbegin(); it != removed.crend(); ++it) {
+        from.removeAt(*it);
+        deltas.append(QVariantMap{{"op", "remove"}, {"index", *it}});
+    }
+
+    // then fix the positions front to back, moving existing objects and inserting new ones
+
+    QHash<QObject *, int> remaining;
+    for (const auto object : std::as_const(from))
+        remaining[object]++;
+
+    for (int i = 0; i < to.size(); ++i) {
+        if (i < from.size() && from[i] == to[i]) {
+            remaining[to[i]]--;
+            continue;
+        }
+
+        if (remaining.value(to[i]) > 0) {
+            const auto j = int(from.indexOf(to[i], i + 1));
+            from.move(j, i);
+            remaining[to[i]]--;
+            deltas.append(QVariantMap{{"op", "move"}, {"from", j}, {"to", i}});
+        } else {
+            from.insert(i, to[i]);
+            deltas.append(QVariantMap{{"op", "insert"}, {"index", i}, {"value", values[i]}});
+        }
+    }
+
+    return deltas;
+}
+} // namespace
+
 QObjectRegistry::QObjectRegistry(QObject *parent)
     : QObject{parent}
+    , _relay{[this](int id, const QVariantList &arguments) { relaySignal(id, arguments); }}
+    , _version{0}
+    , _journalCapacity{4096}
+    , _journalHead{0}
+    , _transactions{0}
+    , _coalescing{false}
+    , _notifyInterval{0}
+    , _lazy{false}
+    , _threadPool{nullptr}
 {
+    static const auto futureTypes = [] {
+        registerFutureType<void>();
+        registerFutureType<bool>();
+        registerFutureType<int>();
+        registerFutureType<double>();
+        registerFutureType<QString>();
+        registerFutureType<QVariantList>();
+        registerFutureType<QVariantMap>();
+        return true;
+    }();
+    Q_UNUSED(futureTypes)
+
     // we need a the notifier slot meta method for our connect signatures
     _notifierSlotIdx = QObjectRegistry::metaObject()->indexOfMethod("onNotifySignal()");
     _notifierSlot = QObjectRegistry::metaObject()->method(_notifierSlotIdx);
+
+    _flushTimer.setSingleShot(true);
+    connect(&_flushTimer, &QTimer::timeout, this, &QObjectRegistry::flush);
+    _clock.start();
+
+    _statsTimer.setInterval(StatsInterval);
+    connect(&_statsTimer, &QTimer::timeout, this, &QObjectRegistry::publishStats);
+}
+
+QObjectRegistry::~QObjectRegistry()
+{
+    // mirrors live in the threads of their objects, those have to delete them
+    for (const auto &ownership : std::as_const(_objects))
+        if (ownership.mirror)
+            ownership.mirror->deleteLater();
 }
 
 void QObjectRegistry::registerObject(const QString &name, const QVariant &variant)
 {
     // todo: check collisions etc
 
-    _get[name] = [variant]() { return variant; };
+    const auto id = _keys.insert(name);
+    _keys[id].set(Slot::Pinned, true);
+    _pinned[id] = variant;
 
     if (!variant.canConvert<QObject *>() || variant.isNull())
         return;
 
     auto object = variant.value<QObject *>();
-    auto metaObject = object->metaObject();
+    own(object, id, true);
 
-    qCInfo(self) << this << "register object" << metaObject->className() << name;
-    connect(object, &QObject::destroyed, this, [this, name]() { this->deregisterObject(name); });
+    const auto descriptor = _objects[object].descriptor;
+    qCInfo(self) << this << "register object" << descriptor->metaObject()->className() << name;
 
     // register properties
 
-    for (int i = 0; i < metaObject->propertyCount(); ++i) {
-        auto property = metaObject->property(i);
-        auto propertyName = QString{"%1.%2"}.arg(name, property.name());
-        this->registerProperty(propertyName, object, property);
+    for (int i = 0; i < descriptor->properties().size(); ++i) {
+        auto propertyName = QString{"%1.%2"}.arg(name, descriptor->properties()[i].name);
+        this->registerProperty(propertyName, object, *descriptor, i);
     }
 
     // register methods
 
-    for (int i = 0; i < metaObject->methodCount(); ++i) {
-        auto method = metaObject->method(i);
-        auto methodName = QString{"%1.%2"}.arg(name, method.name());
-        this->registerMethod(methodName, object, method);
+    for (int i = 0; i < descriptor->methods().size(); ++i) {
+        auto methodName = QString{"%1.%2"}.arg(name, descriptor->methods()[i].name);
+        this->registerMethod(methodName, object, *descriptor, i);
+    }
+
+    // register signals
+
+    for (int i = 0; i < descriptor->signalMethods().size(); ++i) {
+        auto signalName = QString{"%1.%2"}.arg(name, descriptor->signalMethods()[i].name);
+        this->registerSignal(signalName, object, *descriptor, i);
     }
 }
 
 void QObjectRegistry::deregisterObject(const QString &name)
 {
     qCInfo(self) << "deregister object:" << name;
+    _keys.remove(name, [this](int id, const Slot &slot) { removeSlot(id, slot); });
+}
+
+void QObjectRegistry::deregisterObject(QObject *object)
+{
+    qCInfo(self) << "deregister object:" << object;
+
+    const auto it = _objects.constFind(object);
+
+    if (it == _objects.cend())
+        return;
 
-#if QT_VERSION_MAJOR == 6
-    _get.removeIf([name](decltype(_get)::iterator it) { return it.key().startsWith(name); });
-    _set.removeIf([name](decltype(_set)::iterator it) { return it.key().startsWith(name); });
-    _methods.removeIf([name](decltype(_methods)::iterator it) { return it.key().startsWith(name); });
-#else
-    auto getters = _get.keys();
-    for (const auto &getter : std::as_const(getters))
-        if (getter.startsWith(name))
-            _get.remove(getter);
+    // the keys below the names the object is registered under go with them, the rest one by one.
+    // ids may have been reused by other keys in the meantime, so check before removing
 
-    auto setters = _set.keys();
-    for (const auto &setter : std::as_const(setters))
-        if (setter.startsWith(name))
-            _set.remove(setter);
+    const auto ownership = *it;
 
-    auto methods = _methods.keys();
-    for (const auto &method : std::as_const(methods))
-        if (method.startsWith(name))
-            _methods.remove(method);
-#endif
+    for (const auto id : ownership.anchors)
+        if (_keys.contains(id) && _keys[id].is(Slot::Pinned) && _pinned.value(id).value<QObject *>() == object)
+            deregisterObject(_keys.key(id));
+
+    for (const auto id : ownership.keys)
+        if (_keys.contains(id) && _keys[id].object == object)
+            deregisterObject(_keys.key(id));
 }
 
-void QObjectRegistry::deregisterObject(QObject *object)
+QStringList QObjectRegistry::keys(const QString &prefix) const
 {
-    qCInfo(self) << "deregister object:" << object;
+    return _keys.keys(prefix);
+}
+
+bool QObjectRegistry::isSignal(const QString &key) const
+{
+    const auto id = _keys.find(key);
+    return id >= 0 && _keys[id].type == Slot::Signal;
+}
+
+QMetaType QObjectRegistry::typeOf(const QString &key)
+{
+    const auto id = resolve(key);
+
+    if (id < 0 || _keys[id].type != Slot::Property)
+        return QMetaType{};
+
+    const auto &property = _keys[id].descriptor->properties()[_keys[id].index];
+    return property.dynamic ? QMetaType{} : property.type;
+}
+
+bool QObjectRegistry::isLazy() const
+{
+    return _lazy;
+}
+
+void QObjectRegistry::setLazy(bool lazy)
+{
+    _lazy = lazy;
+}
+
+bool QObjectRegistry::isCoalescing() const
+{
+    return _coalescing;
+}
+
+void QObjectRegistry::setCoalescing(bool coalescing)
+{
+    _coalescing = coalescing;
+
+    if (!_coalescing)
+        flush();
+}
+
+int QObjectRegistry::notifyInterval() const
+{
+    return _notifyInterval;
+}
+
+void QObjectRegistry::setNotifyInterval(int msecs)
+{
+    _notifyInterval = qMax(0, msecs);
+}
+
+void QObjectRegistry::setNotifyInterval(const QString &key, int msecs)
+{
+    _policies[key].interval = qMax(0, msecs);
+
+    const auto id = _keys.find(key);
+
+    if (id >= 0)
+        applyPolicy(id);
+}
 
-    //auto it0 = std::remove_if(_get.begin(), _get.end(), [object](const QPair<QObject *, QMetaProperty> &v) { return object == v.first; });
-    //_properties.erase(it0, _properties.end());
+void QObjectRegistry::setImmediate(const QString &key, bool immediate)
+{
+    _policies[key].immediate = immediate;
+
+    const auto id = _keys.find(key);
 
-    auto it1 = std::remove_if(_methods.begin(), _methods.end(), [object](const QPair<QObject *, QMetaMethod> &v) { return object == v.first; });
+    if (id >= 0)
+        applyPolicy(id);
+}
 
-#if QT_VERSION_MAJOR == 6
-    _methods.erase(it1, _methods.end());
-#else
-    while (it1 != _methods.end())
-        _methods.erase(it1);
-#endif
+quint64 QObjectRegistry::version() const
+{
+    return _version;
+}
+
+quint64 QObjectRegistry::version(const QString &key) const
+{
+    const auto id = _keys.find(key);
+    return id < 0 ? 0 : _keys[id].version;
+}
+
+bool QObjectRegistry::isVersioned(const QString &key)
+{
+    return !key.startsWith(StatsPrefix);
+}
+
+int QObjectRegistry::journalCapacity() const
+{
+    return _journalCapacity;
+}
+
+void QObjectRegistry::setJournalCapacity(int capacity)
+{
+    QList<Change> journal;
+    capacity = qMax(0, capacity);
+
+    for (int i = qMax(0, int(_journal.size()) - capacity); i < _journal.size(); ++i)
+        journal.append(_journal[(_journalHead + i) % _journal.size()]);
+
+    _journal = journal;
+    _journalHead = 0;
+    _journalCapacity = capacity;
+}
+
+QList<QObjectRegistry::Change> QObjectRegistry::changesSince(quint64 version, bool *complete) const
+{
+    QList<Change> changes;
+
+    // without the change right after version in the journal something might be missing
+
+    *complete = version == _version || (version < _version && !_journal.isEmpty() && _journal[_journalHead].version <= version + 1);
+
+    if (!*complete || version == _version)
+        return changes;
+
+    QHash<QString, qsizetype> latest;
+
+    for (int i = 0; i < _journal.size(); ++i) {
+        const auto &change = _journal[(_journalHead + i) % _journal.size()];
+
+        if (change.version <= version)
+            continue;
+
+        const auto it = latest.constFind(change.key);
+
+        if (it == latest.cend()) {
+            latest.insert(change.key, changes.size());
+            changes.append(change);
+        } else {
+            changes[*it] = change;
+        }
+    }
+
+    return changes;
 }
 
 QVariant QObjectRegistry::get(const QString &key)
 {
-    auto it = _get.find(key);
+    if (key.startsWith(StatsPrefix))
+        return _stats.value(key.mid(StatsPrefix.size()));
+
+    auto id = resolve(key);
 
-    if (it == _get.end()) {
+    if (id < 0) {
         qCCritical(self) << "no getter for key:" << key;
         return QVariant{};
     }
 
-#if 1
-    return (*it)();
-#else
-    return it->second.read(it->first);
-#endif
+    RegistryStats::Measurement measurement{statsOf(id), RegistryStats::Get};
+    const auto &slot = _keys[id];
+
+    if (slot.is(Slot::Pinned))
+        return _pinned.value(id);
+
+    if (slot.type != Slot::Property) {
+        qCCritical(self) << "no getter for key:" << key;
+        return QVariant{};
+    }
+
+    return read(slot);
+}
+
+QVariantMap QObjectRegistry::snapshot(const QString &pattern)
+{
+    if (pattern.startsWith(StatsPrefix.chopped(1)))
+        return statsSnapshot(pattern);
+
+    // a glob is matched against the subtree of its literal part up to the last dot
+
+    static const QRegularExpression wildcards{"[*?\\[]"};
+    const auto wildcard = pattern.indexOf(wildcards);
+
+    QString prefix = pattern;
+    QRegularExpression glob;
+
+    if (wildcard >= 0) {
+        prefix = pattern.left(pattern.lastIndexOf(u'.', wildcard) + 1);
+        glob.setPattern(QRegularExpression::wildcardToRegularExpression(pattern));
+    }
+
+    if (_lazy)
+        expandSubtree(prefix);
+
+    // collect first, property getters must not run while the table is traversed
+
+    QList<int> ids;
+    _keys.forEach(prefix, [this, &ids, &glob, wildcard](int id, const Slot &slot) {
+        if (slot.type != Slot::Property || slot.kind == ClassDescriptor::Object)
+            return;
+
+        if (slot.kind == ClassDescriptor::List) {
+            const auto elements = _elements.value(id);
+            if (!std::all_of(elements.cbegin(), elements.cend(), [](const QObject *object) { return object == nullptr; }))
+                return;
+        }
+
+        if (wildcard < 0 || glob.match(_keys.key(id)).hasMatch())
+            ids.append(id);
+    });
+
+    QVariantMap values;
+
+    for (const auto id : std::as_const(ids)) {
+        values.insert(_keys.key(id), read(_keys[id]));
+    }
+
+    qCDebug(self) << "snapshot" << pattern << values.size() << "values";
+    return values;
 }
 
 void QObjectRegistry::set(const QString &key, const QVariant &value)
 {
-    auto it = _set.find(key);
-    //auto it = _properties.find(key);
+    auto id = resolve(key);
+
+    if (id < 0 || _keys[id].type != Slot::Property) {
+        qCCritical(self) << "no setter for key:" << key;
+        return;
+    }
+
+    RegistryStats::Measurement measurement{statsOf(id), RegistryStats::Set};
+    const auto &slot = _keys[id];
+    const auto &property = slot.descriptor->properties()[slot.index].property;
 
-    if (it == _set.end()) {
+    if (!property.isWritable()) {
         qCCritical(self) << "no setter for key:" << key;
         return;
     }
 
-    //if (!value.canConvert(it->metaType())) {
-    //    qCCritical(self) << "cannot convert" << value << "to" << it->second.typeName();
-    //    return;
-    //}
+    write(slot, value);
+}
+
+bool QObjectRegistry::setBatch(const QVariantMap &values, bool atomic)
+{
+    // check and convert everything before the first write
+
+    QList<QPair<QString, QVariant>> writes;
+    writes.reserve(values.size());
+    bool ok = true;
+
+    for (auto it = values.cbegin(); it != values.cend(); ++it) {
+        const auto id = resolve(it.key());
+
+        if (id < 0 || _keys[id].type != Slot::Property || !_keys[id].descriptor->properties()[_keys[id].index].property.isWritable()) {
+            qCCritical(self) << "no setter for key:" << it.key();
+            ok = false;
+            continue;
+        }
+
+        const auto &type = _keys[id].descriptor->properties()[_keys[id].index].type;
+        auto value = it.value();
+
+        if (type.id() != QMetaType::QVariant && value.metaType() != type && !value.convert(type)) {
+            qCCritical(self) << "cannot convert" << it.value() << "to" << type.name() << "for" << it.key();
+            ok = false;
+            continue;
+        }
+
+        writes.append({it.key(), value});
+    }
+
+    if (atomic && !ok) {
+        qCWarning(self) << "rejected batch of" << values.size() << "values";
+        return false;
+    }
+
+    // value notifies are held back until the batch is done, then every key is emitted once
+
+    _transactions++;
+
+    for (const auto &entry : std::as_const(writes)) {
+        // structural writes may have re-registered keys of this batch
+        const auto id = _keys.find(entry.first);
+
+        if (id < 0) {
+            ok = false;
+            continue;
+        }
+
+        ok &= write(_keys[id], entry.second);
+    }
+
+    if (--_transactions == 0)
+        flush();
 
-    (*it)(value);
+    return ok;
 }
 
 QVariant QObjectRegistry::call(const QString &function, const QVariantList &arguments)
 {
-    return {};
+    const auto id = resolve(function);
+    const auto invoker = overload(id, function, arguments);
+
+    if (invoker == nullptr)
+        return QVariant{};
+
+    RegistryStats::Measurement measurement{statsOf(id), RegistryStats::Call};
+
+    if (_keys[id].is(Slot::Remote)) {
+        qCWarning(self) << function << "runs in another thread, its result is only available from callAsync";
+        callAsync(function, arguments);
+        return QVariant{};
+    }
+
+    return invoker->invoke(_keys[id].object, arguments);
+}
+
+QFuture<QVariant> QObjectRegistry::callAsync(const QString &function, const QVariantList &arguments)
+{
+    auto promise = std::make_shared<QPromise<QVariant>>();
+    auto future = promise->future();
+    promise->start();
+
+    const auto id = resolve(function);
+    const auto invoker = overload(id, function, arguments);
+
+    if (invoker == nullptr) {
+        fulfill(promise, QVariant{});
+        return future;
+    }
+
+    // calls that leave our thread are only measured up to there
+    RegistryStats::Measurement measurement{statsOf(id), RegistryStats::Call};
+
+    const auto object = _keys[id].object;
+    const auto run = [promise, invoker, object, arguments] { fulfill(promise, invoker->invoke(object, arguments)); };
+
+    // if the object is gone before its thread or the pool gets to the call, the dropped promise cancels the future
+
+    if (_keys[id].is(Slot::Remote)) {
+        invokeRemote(object, run);
+    } else if (_threadPool && invoker->isConcurrent()) {
+        _threadPool->start([guard = guardOf(object), run] {
+            QReadLocker locker{&guard->lock};
+
+            if (guard->alive)
+                run();
+        });
+    } else {
+        run();
+    }
+
+    return future;
+}
+
+QThreadPool *QObjectRegistry::threadPool() const
+{
+    return _threadPool;
+}
+
+void QObjectRegistry::setThreadPool(QThreadPool *pool)
+{
+    _threadPool = pool;
+}
+
+RegistryStats &QObjectRegistry::stats()
+{
+    return _stats;
+}
+
+void QObjectRegistry::subscribe(const QString &key)
+{
+    if (_subscriptions[key]++ > 0)
+        return;
+
+    qCDebug(self) << "first subscriber for" << key;
+
+    if (key.startsWith(StatsPrefix)) {
+        _statsTimer.start();
+        return;
+    }
+    const auto id = resolve(key);
+
+    if (id >= 0)
+        wireNotify(id);
+}
+
+void QObjectRegistry::unsubscribe(const QString &key)
+{
+    auto it = _subscriptions.find(key);
+
+    if (it == _subscriptions.end()) {
+        qCWarning(self) << "not subscribed to key:" << key;
+        return;
+    }
+
+    if (--(*it) > 0)
+        return;
+
+    qCDebug(self) << "last subscriber gone for" << key;
+    _subscriptions.erase(it);
+    const auto id = _keys.find(key);
+
+    if (id >= 0)
+        unwireNotify(id);
+}
+
+void QObjectRegistry::flush()
+{
+    const auto dirty = std::exchange(_dirty, {});
+    const auto now = _clock.elapsed();
+    auto next = std::numeric_limits<qint64>::max();
+
+    for (const auto id : dirty) {
+        // keys removed or flushed in the meantime are not dirty anymore
+        if (!_keys.contains(id) || !_keys[id].is(Slot::Dirty))
+            continue;
+
+        auto &slot = _keys[id];
+        const auto throttle = _throttles.find(id);
+
+        if (throttle != _throttles.end()) {
+            const auto elapsed = now - throttle->flushed;
+
+            if (_coalescing && elapsed < throttle->interval) {
+                _dirty.append(id);
+                next = qMin(next, throttle->interval - elapsed);
+                continue;
+            }
+
+            throttle->flushed = now;
+        }
+
+        slot.set(Slot::Dirty, false);
+
+        const auto key = _keys.key(id);
+        const auto value = read(slot);
+
+        qCDebug(self) << "flush" << key << value;
+        publish(id, value);
+    }
+
+    if (!_dirty.isEmpty() && !_flushTimer.isActive())
+        _flushTimer.start(int(qMax<qint64>(next, _notifyInterval)));
 }
 
 void QObjectRegistry::onNotifySignal()
 {
-    auto notifyIt = _notify.find({sender(), senderSignalIndex()});
+    const auto object = sender();
+    const auto notifyIt = _notify.constFind({object, senderSignalIndex()});
 
-    if (notifyIt == _notify.end()) {
-        qCCritical(self) << "failed to find notifies for" << sender() << senderSignalIndex();
+    if (notifyIt == _notify.cend()) {
+        qCCritical(self) << "failed to find notifies for" << object << senderSignalIndex();
         return;
     }
 
-    (*notifyIt)();
+    // copied, the handlers re-register keys. aliases of a property share one read
+    const auto ids = *notifyIt;
+    QHash<int, QVariant> values;
+
+    for (const auto id : ids) {
+        if (!_keys.contains(id) || _keys[id].object != object || _keys[id].type != Slot::Property)
+            continue;
+
+        RegistryStats::Measurement measurement{statsOf(id), RegistryStats::Notify};
+
+        if (coalesce(id))
+            continue;
+
+        auto value = values.constFind(_keys[id].index);
+
+        if (value == values.cend())
+            value = values.insert(_keys[id].index, read(_keys[id]));
+
+        notifyProperty(id, *value);
+    }
 }
 
 //const QMap<QString, QPair<QObject *, QMetaProperty> > &QObjectRegistry::properties() const
@@ -147,216 +725,669 @@ void QObjectRegistry::onNotifySignal()
 //    return _properties;
 //}
 
-const QMap<QString, QPair<QObject *, QMetaMethod> > &QObjectRegistry::methods() const
+QMap<QString, QPair<QObject *, QMetaMethod>> QObjectRegistry::methods() const
 {
-    return _methods;
+    QMap<QString, QPair<QObject *, QMetaMethod>> methods;
+
+    _keys.forEach({}, [this, &methods](int id, const Slot &slot) {
+        if (slot.type == Slot::Method)
+            methods.insert(_keys.key(id), {slot.object, slot.descriptor->methods()[slot.index].overloads.first().method()});
+    });
+
+    return methods;
 }
 
-void QObjectRegistry::registerProperty(const QString &propertyName, QObject *object, const QMetaProperty &property)
+void QObjectRegistry::registerProperty(const QString &propertyName, QObject *object, const ClassDescriptor &descriptor, int index)
 {
-    qCInfo(self) << "register property:" << property.typeName() << propertyName;
+    const auto &property = descriptor.properties()[index];
+    qCInfo(self) << "register property:" << property.type.name() << propertyName;
 
-    // _properties[propertyName] = {object, property};
+    if (!property.property.isReadable()) {
+        qCCritical(self) << "cannot handle ungettable property";
+        return;
+    }
 
-    const auto propertyValue = property.read(object);
+    const auto id = _keys.insert(propertyName);
+    own(object, id, false);
 
-    if (!property.isReadable()) {
-        qCCritical(self) << "cannot handle ungettable property";
+    auto &slot = assign(id, Slot::Property, object, descriptor, index);
+
+    // values of remote objects are not known before their first mirror update, which registers them again
+    const auto propertyValue = read(slot);
+    const auto kind = property.dynamic ? ClassDescriptor::kindOf(propertyValue.metaType()) : property.kind;
+
+    slot.kind = kind;
+    applyPolicy(id);
+
+    if (!_keys[id].is(Slot::Remote) || propertyValue.isValid())
+        publish(id, propertyValue);
+
+    // handle special types
+
+    if (!property.type.isValid()) {
+        qCCritical(self) << "invalid property type:" << property.name;
         return;
     }
 
-    if (property.isWritable()) {
-        _set[propertyName] = [object, property](const QVariant &value) { property.write(object, value); };
+    switch (kind) {
+    case ClassDescriptor::Object:
+        qCDebug(self) << "recurse object:" << propertyName << propertyValue;
+
+        // the keys below depend on the object, so its notify stays connected without subscribers.
+        // the mirror of a remote object is connected to all of them anyway
+        if (!_keys[id].is(Slot::Remote))
+            attachNotifier(id);
+
+        if (_lazy)
+            this->registerPending(id, propertyValue);
+        else
+            this->registerObject(propertyName, propertyValue);
+        break;
+
+    case ClassDescriptor::List:
+        qCDebug(self) << "recurse list like:" << propertyValue << property.type.name();
+        _elements[id] = objectsOf(propertyValue.toList());
+
+        // the elements keys depend on lists of objects, so their notifies stay connected without subscribers.
+        // lists of plain values follow their subscriptions. the mirror of a remote object is connected to all of them anyway
+        _keys[id].set(Slot::Objects, property.dynamic ? ClassDescriptor::holdsObjects(propertyValue.metaType()) : property.objects);
+
+        if (_keys[id].is(Slot::Objects) && !_keys[id].is(Slot::Remote))
+            attachNotifier(id);
+        else if (_subscriptions.contains(propertyName))
+            this->wireNotify(id);
+
+        if (_lazy)
+            _keys[id].set(Slot::Pending, true);
+        else
+            this->registerElements(propertyName, propertyValue.toList());
+        break;
+
+    case ClassDescriptor::Value:
+        if (_subscriptions.contains(propertyName))
+            this->wireNotify(id);
+        break;
+    }
+}
+
+void QObjectRegistry::registerMethod(const QString &methodName, QObject *object, const ClassDescriptor &descriptor, int index)
+{
+    const auto id = _keys.insert(methodName);
+    own(object, id, false);
+    assign(id, Slot::Method, object, descriptor, index);
+}
+
+void QObjectRegistry::registerSignal(const QString &signalName, QObject *object, const ClassDescriptor &descriptor, int index)
+{
+    // a property or method of the same name, e.g. pressed of a MouseArea, keeps its key
+    if (const auto existing = _keys.find(signalName); existing >= 0) {
+        const auto &slot = _keys[existing];
+
+        if (slot.object == object && (slot.type == Slot::Property || slot.type == Slot::Method)) {
+            qCDebug(self) << "signal shadowed by a property or method:" << signalName;
+            return;
+        }
     }
 
-    _get[propertyName] = [object, property]() {
-        return property.read(object);
-    };
+    const auto id = _keys.insert(signalName);
+    own(object, id, false);
 
-    emit valueChanged(propertyName, propertyValue);
+    _relay.disconnectSignal(_relays.value(id, -1));
+    _relays.remove(id);
 
-    // handle special types
+    assign(id, Slot::Signal, object, descriptor, index);
 
-    auto propType = QMetaType{property.userType()};
+    if (_subscriptions.contains(signalName))
+        this->wireNotify(id);
+}
 
-    if (!propType.isValid()) {
-        qCCritical(self) << "invalid property type:" << property.name();
-        return;
+void QObjectRegistry::registerElements(const QString &listName, const QVariantList &elements, int from)
+{
+    for (int i = from; i < elements.size(); ++i) {
+        if (!elements[i].metaType().flags().testFlag(QMetaType::PointerToQObject))
+            continue;
+
+        auto elementName = QString{"%1.%2"}.arg(listName, QString::number(i));
+        qCDebug(self) << "recurse:" << elementName << elements[i];
+
+        if (_lazy)
+            this->registerPending(_keys.insert(elementName), elements[i]);
+        else
+            this->registerObject(elementName, elements[i]);
     }
+}
 
-    // handle qobject*
+void QObjectRegistry::registerPending(int id, const QVariant &variant)
+{
+    // only a weak record of the object, it might be gone by the time someone asks for it
+    const auto child = variant.value<QObject *>();
+    auto &slot = _keys[id];
+    slot.set(Slot::Pinned, true);
+    slot.set(Slot::Pending, child != nullptr);
+    _pinned[id] = variant;
+
+    if (child)
+        _children[id] = child;
+}
 
-    if (propType.flags().testFlag(QMetaType::PointerToQObject)) {
-        auto propertyObject = property.read(object).value<QObject *>();
-        qCDebug(self) << "recurse object:" << propertyName << propertyObject;
+QObjectRegistry::Slot &QObjectRegistry::assign(int id, Slot::Type type, QObject *object, const ClassDescriptor &descriptor, int index)
+{
+    // a key registered again starts over, only its version and a pending flush survive
+    detachNotifier(id);
 
-        this->registerObject(propertyName, propertyValue);
+    auto &slot = _keys[id];
+    slot = Slot{object, &descriptor, slot.version, index, type, ClassDescriptor::Value, quint8(slot.flags & Slot::Dirty)};
+    slot.set(Slot::Remote, _objects[object].mirror != nullptr);
 
-        if (property.hasNotifySignal()) {
-            _notify[{object, property.notifySignalIndex()}] = [this, propertyName, property, object, propertyObject]() {
-                const auto newValue = property.read(object);
+    _pinned.remove(id);
+    _children.remove(id);
 
-                qCDebug(self) << "value changed" << propertyName << newValue;
-                emit valueChanged(propertyName, newValue);
+    return slot;
+}
 
-                // todo: this overwrites the read, write and call methods of the old object, but the old objects
-                // destroy signal would still remove them from cb maps if it gets deleted
+const MethodInvoker *QObjectRegistry::overload(int id, const QString &function, const QVariantList &arguments) const
+{
+    if (id < 0 || _keys[id].type != Slot::Method) {
+        qCCritical(self) << "no method for key:" << function;
+        return nullptr;
+    }
 
-                disconnect(propertyObject, property.notifySignal(), this, _notifierSlot);
-                this->deregisterObject(propertyName);
-                this->registerProperty(propertyName, object, property);
-            };
+    const auto &slot = _keys[id];
 
-            connect(object, &QObject::destroyed, this, [this, object, index = property.notifySignalIndex()] { _notify.remove({object, index}); });
-            // connect(object, property.notifySignal(), this, _notifierSlot);
-        }
+    for (const auto &invoker : slot.descriptor->methods()[slot.index].overloads)
+        if (invoker.parameterCount() == arguments.size())
+            return &invoker;
+
+    qCCritical(self) << "no overload of" << function << "takes" << arguments.size() << "arguments";
+    return nullptr;
+}
+
+QVariant QObjectRegistry::read(const Slot &slot) const
+{
+    if (!slot.is(Slot::Remote))
+        return readProperty(slot.object, slot.descriptor->properties()[slot.index]);
+
+    const auto it = _objects.constFind(slot.object);
+    return it == _objects.cend() ? QVariant{} : it->values.value(slot.index);
+}
+
+bool QObjectRegistry::write(const Slot &slot, const QVariant &value)
+{
+    const auto &property = slot.descriptor->properties()[slot.index].property;
+
+    if (!slot.is(Slot::Remote))
+        return property.write(slot.object, value);
+
+    // the change comes back with the next mirror update
+    const auto object = slot.object;
+    return invokeRemote(object, [object, property, value] { property.write(object, value); });
+}
+
+bool QObjectRegistry::invokeRemote(QObject *object, const std::function<void()> &function)
+{
+    const auto it = _objects.constFind(object);
+
+    if (it == _objects.cend() || !it->guard)
+        return false;
+
+    // a destructor running meanwhile waits for us, its posted events are dropped along with it
+    QReadLocker locker{&it->guard->lock};
+    return it->guard->alive && QMetaObject::invokeMethod(object, function, Qt::QueuedConnection);
+}
+
+std::shared_ptr<QObjectRegistry::Guard> QObjectRegistry::guardOf(QObject *object)
+{
+    auto &guard = _objects[object].guard;
+
+    if (!guard) {
+        guard = std::make_shared<Guard>();
+
+        // direct, in the thread the object dies in
+        connect(object, &QObject::destroyed, [guard = guard] {
+            QWriteLocker locker{&guard->lock};
+            guard->alive = false;
+        });
     }
 
-    // handle simple arrays
+    return guard;
+}
 
-    else if (propertyValue.canConvert<QVariantList>() && propertyValue.typeId() != QMetaType::QString) {
-        auto variantList = propertyValue.value<QVariantList>();
-        qCDebug(self) << "recurse list like:" << variantList << propType.name();
+int QObjectRegistry::resolve(const QString &key)
+{
+    auto id = _keys.find(key);
 
-        _notify[{object, property.notifySignalIndex()}] = [this, propertyName, property, object]() {
-            const auto newValue = property.read(object).toList();
+    if (!_lazy || (id >= 0 && !_keys[id].is(Slot::Pending)))
+        return id;
 
-            qCDebug(self) << "list value changed:" << propertyName << newValue;
-            emit valueChanged(propertyName, newValue);
+    // expand the pending parents of the key from the top down
 
-            this->deregisterObject(propertyName + '.');
+    for (auto separator = key.indexOf(u'.'); separator >= 0; separator = key.indexOf(u'.', separator + 1)) {
+        const auto parent = _keys.find(key.left(separator));
 
-            for (int i = 0; i < newValue.size(); ++i) {
-                auto variantType = QMetaType{newValue[i].userType()};
+        if (parent >= 0 && _keys[parent].is(Slot::Pending))
+            expand(parent);
+    }
 
-                if (variantType.flags().testFlag(QMetaType::PointerToQObject)) {
-                    auto variant = newValue[i].value<QObject *>();
-                    auto variantName = QString{"%1.%2"}.arg(propertyName, QString::number(i));
-                    _get[variantName] = [variant]() { return QVariant::fromValue(variant); };
+    id = _keys.find(key);
 
-                    qCDebug(self) << "recurse:" << variantName << variant;
-                    this->registerObject(variantName, newValue[i]);
-                }
-            }
-        };
+    if (id >= 0 && _keys[id].is(Slot::Pending) && _keys[id].is(Slot::Pinned) && _children.value(id).isNull()) {
+        qCInfo(self) << "pending object is gone:" << key;
+        deregisterObject(key);
+        return -1;
+    }
 
-        for (int i = 0; i < variantList.size(); ++i) {
-            auto variantType = QMetaType{variantList[i].userType()};
+    return id;
+}
 
-            if (variantType.flags().testFlag(QMetaType::PointerToQObject)) {
-                auto variant = variantList[i].value<QObject *>();
-                auto variantName = QString{"%1.%2"}.arg(propertyName, QString::number(i));
-                _get[variantName] = [variant = variantList[i]]() {
-                    qCDebug(self) << "@" << variant.value<QObject *>() << variant.value<QObject *>()->dynamicPropertyNames();
-                    return variant;
-                };
+void QObjectRegistry::expand(int id)
+{
+    const auto key = _keys.key(id);
+    const auto slot = _keys[id];
+    const auto child = _children.take(id);
+    _keys[id].set(Slot::Pending, false);
 
-                qCDebug(self) << "recurse:" << variantName << variant;
-                this->registerObject(variantName, variantList[i]);
-            }
+    qCDebug(self) << "expand:" << key;
+
+    if (!slot.is(Slot::Pinned)) {
+        this->registerElements(key, read(slot).toList());
+    }
+
+    else if (child.isNull()) {
+        qCInfo(self) << "pending object is gone:" << key;
+        this->deregisterObject(key);
+    }
+
+    else {
+        this->registerObject(key, _pinned.value(id));
+    }
+}
+
+void QObjectRegistry::expandSubtree(const QString &prefix)
+{
+    // the parents and the prefix itself first, then everything below until nothing pending is left
+
+    if (!prefix.isEmpty()) {
+        const auto id = resolve(prefix.endsWith(u'.') ? prefix.chopped(1) : prefix);
+
+        if (id >= 0 && _keys[id].is(Slot::Pending))
+            expand(id);
+    }
+
+    for (;;) {
+        QList<int> pending;
+        _keys.forEach(prefix, [&pending](int id, const Slot &slot) {
+            if (slot.is(Slot::Pending))
+                pending.append(id);
+        });
+
+        if (pending.isEmpty())
+            return;
+
+        // expanding registers and removes keys, so the table is not traversed meanwhile
+        for (const auto id : std::as_const(pending)) {
+            if (_keys.contains(id) && _keys[id].is(Slot::Pending))
+                expand(id);
         }
     }
+}
 
-    else if (property.hasNotifySignal()) {
-        _notify[{object, property.notifySignalIndex()}] = [this, propertyName, property, object]() {
-            const auto propertyValue = property.read(object);
-            qCDebug(self) << "object property changed" << propertyName << propertyValue;
-            emit valueChanged(propertyName, propertyValue);
-        };
+void QObjectRegistry::notifyProperty(int id)
+{
+    if (!coalesce(id))
+        notifyProperty(id, read(_keys[id]));
+}
 
-        connect(object, &QObject::destroyed, this, [this, object, index = property.notifySignalIndex()] { _notify.remove({object, index}); });
-        connect(object, property.notifySignal(), this, _notifierSlot);
+void QObjectRegistry::notifyProperty(int id, const QVariant &value)
+{
+    // copies, the handlers below re-register this very key
+    const auto slot = _keys[id];
+    const auto key = _keys.key(id);
+
+    switch (slot.kind) {
+    case ClassDescriptor::Object: {
+        qCDebug(self) << "value changed" << key << value;
+
+        // registered again with the new object, which publishes it. the descriptor
+        // is held meanwhile, the removed key might have been the last one using it
+        const auto descriptor = _objects[slot.object].descriptor;
+        this->deregisterObject(key);
+        this->registerProperty(key, slot.object, *descriptor, slot.index);
+        break;
+    }
+
+    case ClassDescriptor::List:
+        qCDebug(self) << "list value changed:" << key << value;
+        this->updateElements(id, value.toList());
+        break;
+
+    case ClassDescriptor::Value:
+        qCDebug(self) << "object property changed" << key << value;
+        publish(id, value);
+        break;
     }
 }
 
-void QObjectRegistry::registerMethod(const QString &methodName, QObject *object, const QMetaMethod &method)
+bool QObjectRegistry::coalesce(int id)
 {
-    if (method.access() != QMetaMethod::Public)
+    // coalesced values and values changed by a batch are read once when they get flushed
+    if (_keys[id].kind != ClassDescriptor::Value || (_transactions == 0 && (!_coalescing || _keys[id].is(Slot::Immediate))))
+        return false;
+
+    markDirty(id);
+    return true;
+}
+
+void QObjectRegistry::relaySignal(int id, const QVariantList &arguments)
+{
+    if (!_keys.contains(id) || !_relays.contains(id))
         return;
 
-    if (method.methodType() == QMetaMethod::Signal)
+    emit signalEmitted(_keys.key(id), arguments);
+}
+
+void QObjectRegistry::updateElements(int id, const QVariantList &elements)
+{
+    const auto key = _keys.key(id);
+    const auto previous = _elements.value(id);
+    const auto current = objectsOf(elements);
+
+    // lists without objects have no identities to diff, they change as a whole
+
+    const auto isNull = [](const QObject *object) { return object == nullptr; };
+
+    if (std::all_of(previous.cbegin(), previous.cend(), isNull) && std::all_of(current.cbegin(), current.cend(), isNull)) {
+        _elements[id] = current;
+        publish(id, elements);
         return;
+    }
 
-    _call[methodName] = [method, object](const QVariantList &args) {
-        if (method.parameterCount() != args.size()) {
-            qCCritical(self) << "invalid arg size:" << method.parameterCount() << args.size();
-            return QVariant();
-        }
+    const auto deltas = diffObjects(previous, current, elements);
+    _elements[id] = current;
 
-        QVariantList variants;
+    if (deltas.isEmpty())
+        return;
 
-        for (int i = 0; i < args.size(); i++) {
-            if (method.parameterType(i) == QMetaType::QVariant) {
-                variants.append(args[i]);
-                continue;
-            }
+    // element keys are positions, so everything from the first changed position on moves
 
-            QVariant copy{args[i]};
+    int first = 0;
+    while (first < previous.size() && first < current.size() && previous[first] == current[first])
+        ++first;
 
-#if QT_VERSION_MAJOR == 5
-            auto convertTarget = QMetaType{method.parameterType(i)}.id();
-#else
-            auto convertTarget = QMetaType{method.parameterType(i)};
-#endif
+    for (int i = first; i < previous.size(); ++i)
+        this->deregisterObject(QString{"%1.%2"}.arg(key, QString::number(i)));
 
-            if (!copy.convert(convertTarget)) {
-                qCCritical(self) << "cannot convert" << args[i] << "to" << method.parameterNames()[i];
-                return QVariant();
-            }
+    if (!_keys[id].is(Slot::Pending))
+        this->registerElements(key, elements, first);
 
-            variants.append(copy);
-        }
+    qCDebug(self) << "list delta:" << key << deltas;
+    record(id, elements);
+    emit listChanged(key, deltas);
+}
 
-#if QT_VERSION_MAJOR == 5
-        auto returnType = QMetaType{method.returnType()};
-#else
-        auto returnType = method.returnMetaType();
-#endif
+void QObjectRegistry::publish(int id, const QVariant &value)
+{
+    const auto key = record(id, value);
+    emit valueChanged(key, value, _keys[id].version);
+}
 
-        QList<QGenericArgument> gArgs;
-        for (auto const &variant : variants) {
-            QGenericArgument gArg(returnType.name(), const_cast<void *>(variant.constData()));
-            gArgs.append(gArg);
-        }
+QString QObjectRegistry::record(int id, const QVariant &value)
+{
+    const auto key = _keys.key(id);
+    _keys[id].version = ++_version;
 
-#if QT_VERSION_MAJOR == 5
-        QVariant returnValue(method.returnType(), static_cast<void *>(nullptr));
-#else
-        QVariant returnValue(method.returnMetaType(), static_cast<void *>(nullptr));
-#endif
-        QGenericReturnArgument gReturn(method.typeName(), const_cast<void *>(returnValue.constData()));
-
-        try {
-            bool ok = method.invoke( //
-                object,
-                Qt::DirectConnection,
-                gReturn,
-                gArgs.value(0),
-                gArgs.value(1),
-                gArgs.value(2),
-                gArgs.value(3),
-                gArgs.value(4),
-                gArgs.value(5),
-                gArgs.value(6),
-                gArgs.value(7),
-                gArgs.value(8),
-                gArgs.value(9));
-
-            if (!ok) {
-                qCWarning(self) << "calling" << method.methodSignature() << "failed.";
-                return QVariant{};
-            }
-        }
+    if (_journalCapacity == 0)
+        return key;
 
-        catch (const std::exception &error) {
-            qCCritical(self) << "invoking method threw error:" << QString(error.what());
-            return QVariant{};
-        }
+    // the objects may be gone by the time someone catches up, whoever does reads them again
+    const auto kind = ClassDescriptor::kindOf(value.metaType());
+    const auto objects = kind == ClassDescriptor::Object || (kind == ClassDescriptor::List && ClassDescriptor::holdsObjects(value.metaType()));
+    const Change change{key, _version, objects ? QVariant{} : value};
+
+    // ring buffer, once it is full _journalHead points at the oldest change
+
+    if (_journal.size() < _journalCapacity) {
+        _journal.append(change);
+    } else {
+        _journal[_journalHead] = change;
+        _journalHead = (_journalHead + 1) % _journalCapacity;
+    }
+
+    return key;
+}
+
+void QObjectRegistry::markDirty(int id)
+{
+    auto &slot = _keys[id];
+
+    if (slot.is(Slot::Dirty))
+        return;
+
+    slot.set(Slot::Dirty, true);
+    _dirty.append(id);
+
+    if (!_flushTimer.isActive())
+        _flushTimer.start(_notifyInterval);
+}
+
+void QObjectRegistry::applyPolicy(int id)
+{
+    const auto policy = _policies.value(_keys.key(id));
+    _keys[id].set(Slot::Immediate, policy.immediate);
+
+    if (policy.interval > 0)
+        _throttles[id].interval = policy.interval;
+    else
+        _throttles.remove(id);
+}
+
+void QObjectRegistry::wireNotify(int id)
+{
+    const auto &slot = _keys[id];
+
+    if (slot.type == Slot::Signal) {
+        if (_relays.contains(id))
+            return;
+
+        const auto ownership = slot.is(Slot::Remote) ? _objects.constFind(slot.object) : _objects.cend();
+        const auto guard = ownership != _objects.cend() ? ownership->guard.get() : nullptr;
+        QReadLocker locker{guard ? &guard->lock : nullptr};
+
+        if (guard && !guard->alive)
+            return;
+
+        const auto relay = _relay.connectSignal(slot.object, slot.descriptor->signalMethods()[slot.index].method, id);
+
+        if (relay >= 0)
+            _relays.insert(id, relay);
+        return;
+    }
+
+    // remote values are kept up to date by their mirror
+    if (slot.type == Slot::Property && slot.isPlain() && !slot.is(Slot::Remote))
+        attachNotifier(id);
+}
+
+void QObjectRegistry::unwireNotify(int id)
+{
+    const auto &slot = _keys[id];
+
+    if (slot.type == Slot::Signal) {
+        _relay.disconnectSignal(_relays.value(id, -1));
+        _relays.remove(id);
+        return;
+    }
+
+    if (slot.isPlain())
+        detachNotifier(id);
+}
+
+void QObjectRegistry::attachNotifier(int id)
+{
+    const auto &slot = _keys[id];
+    const auto &property = slot.descriptor->properties()[slot.index];
+
+    if (property.notifySignal < 0)
+        return;
+
+    auto &ids = _notify[{slot.object, property.notifySignal}];
+
+    if (ids.contains(id))
+        return;
+
+    ids.append(id);
+
+    if (ids.size() == 1)
+        connect(slot.object, property.property.notifySignal(), this, _notifierSlot);
+}
+
+void QObjectRegistry::detachNotifier(int id)
+{
+    const auto &slot = _keys[id];
+
+    if (slot.type != Slot::Property)
+        return;
+
+    const auto signal = slot.descriptor->properties()[slot.index].notifySignal;
+    auto notifyIt = _notify.find({slot.object, signal});
+
+    if (signal < 0 || notifyIt == _notify.end() || !notifyIt->removeOne(id) || !notifyIt->isEmpty())
+        return;
+
+    _notify.erase(notifyIt);
+    QMetaObject::disconnect(slot.object, signal, this, _notifierSlotIdx);
+}
+
+void QObjectRegistry::removeSlot(int id, const Slot &slot)
+{
+    _elements.remove(id);
+    _children.remove(id);
+    _throttles.remove(id);
+
+    // deregistered keys do not pile up, the stats of a key registered again start over
+    _keyStats.remove(id);
+    _stats.release(_keys.key(id));
+
+    if (slot.object)
+        disown(slot.object, id, false);
+
+    const auto pinned = _pinned.take(id);
+
+    if (pinned.metaType().flags().testFlag(QMetaType::PointerToQObject))
+        disown(pinned.value<QObject *>(), id, true);
+
+    _relay.disconnectSignal(_relays.value(id, -1));
+    _relays.remove(id);
+
+    detachNotifier(id);
+}
+
+RegistryStats::KeyStats *QObjectRegistry::statsOf(int id)
+{
+    if (!_stats.isEnabled())
+        return nullptr;
+
+    auto &stats = _keyStats[id];
+
+    if (stats == nullptr)
+        stats = _stats.track(_keys.key(id));
+
+    return stats.get();
+}
+
+QVariantMap QObjectRegistry::statsSnapshot(const QString &pattern) const
+{
+    static const QRegularExpression wildcards{"[*?\\[]"};
+    const QRegularExpression glob{pattern.contains(wildcards) ? QRegularExpression::wildcardToRegularExpression(pattern) : QString{}};
+
+    QVariantMap values;
+
+    for (const auto &key : _stats.keys()) {
+        const auto statsKey = StatsPrefix + key;
+
+        // same prefix semantics as the key table
+        if (!glob.pattern().isEmpty() ? glob.match(statsKey).hasMatch()
+            : pattern.endsWith(u'.')  ? statsKey.startsWith(pattern)
+                                      : statsKey == pattern || statsKey.startsWith(pattern + u'.'))
+            values.insert(statsKey, _stats.value(key));
+    }
+
+    return values;
+}
+
+void QObjectRegistry::publishStats()
+{
+    bool subscribed = false;
+
+    for (auto it = _subscriptions.cbegin(); it != _subscriptions.cend(); ++it) {
+        if (!it.key().startsWith(StatsPrefix))
+            continue;
 
-        if (method.returnType() == QMetaType::Void) {
-            return QVariant{};
+        subscribed = true;
+        emit valueChanged(it.key(), _stats.value(it.key().mid(StatsPrefix.size())), _version);
+    }
+
+    if (!subscribed)
+        _statsTimer.stop();
+}
+
+void QObjectRegistry::own(QObject *object, int id, bool anchor)
+{
+    auto &ownership = _objects[object];
+
+    if (!ownership.destroyed) {
+        ownership.destroyed = connect(object, &QObject::destroyed, this, qOverload<QObject *>(&QObjectRegistry::deregisterObject));
+        ownership.descriptor = ClassDescriptor::forMetaObject(object->metaObject());
+
+        if (object->thread() != thread()) {
+            guardOf(object);
+
+            ownership.mirror = new ObjectMirror{object, ownership.descriptor};
+            connect(ownership.mirror, &ObjectMirror::valuesRead, this, &QObjectRegistry::updateMirror);
+            ownership.mirror->start();
         }
+    }
+
+    (anchor ? ownership.anchors : ownership.keys).insert(id);
+}
+
+void QObjectRegistry::disown(QObject *object, int id, bool anchor)
+{
+    auto it = _objects.find(object);
+
+    if (it == _objects.end())
+        return;
+
+    (anchor ? it->anchors : it->keys).remove(id);
+
+    if (it->anchors.isEmpty() && it->keys.isEmpty()) {
+        disconnect(it->destroyed);
+
+        if (it->mirror)
+            it->mirror->deleteLater();
+
+        _objects.erase(it);
+    }
+}
+
+void QObjectRegistry::updateMirror(QObject *object, const QList<int> &properties, const QVariantList &values)
+{
+    auto it = _objects.find(object);
+
+    // updates of a mirror that was let go in the meantime
+    if (it == _objects.end() || it->mirror != sender())
+        return;
+
+    for (int i = 0; i < properties.size(); ++i) {
+        if (it->values.size() <= properties[i])
+            it->values.resize(properties[i] + 1);
+
+        it->values[properties[i]] = values[i];
+    }
+
+    // copied, structural changes register keys of the object again
+    const auto ids = it->keys;
 
-        return returnValue;
-    };
+    for (const auto id : ids)
+        if (_keys.contains(id) && _keys[id].object == object && _keys[id].type == Slot::Property && properties.contains(_keys[id].index))
+            notifyProperty(id);
 }
@@ -1,16 +1,47 @@
 #ifndef QOBJECTREGISTRY_H
 #define QOBJECTREGISTRY_H
 
+#include <functional>
+#include <memory>
+#include <type_traits>
+
+#include <QElapsedTimer>
+#include <QFuture>
 #include <QMap>
 #include <QMetaMethod>
 #include <QMetaProperty>
 #include <QObject>
+#include <QPointer>
+#include <QReadWriteLock>
+#include <QSet>
+#include <QTimer>
+
+#include "classdescriptor.h"
+#include "keytable.h"
+#include "objectmirror.h"
+#include "registrystats.h"
+#include "signalrelay.h"
+
+// marks slots and invokables that are safe to run in a pool thread, see QObjectRegistry::setThreadPool()
+#ifndef Q_MOC_RUN
+#define QOPENREMOTE_CONCURRENT
+#endif
+
+class QThreadPool;
 
 class QObjectRegistry : public QObject
 {
     Q_OBJECT
 public:
+    struct Change
+    {
+        QString key;
+        quint64 version;
+        QVariant value;
+    };
+
     explicit QObjectRegistry(QObject *parent = nullptr);
+    ~QObjectRegistry() override;
 
     template<class T>
     void registerObject(const QString &name, T variant)
@@ -23,7 +54,55 @@ public:
     void deregisterObject(QObject *object);
 
     const QMap<QString, QPair<QObject *, QMetaProperty>> &properties() const;
-    const QMap<QString, QPair<QObject *, QMetaMethod>> &methods() const;
+    QMap<QString, QPair<QObject *, QMetaMethod>> methods() const;
+
+    QStringList keys(const QString &prefix = QString()) const;
+    bool isSignal(const QString &key) const;
+
+    // the declared type of a property key, so values from the wire can be converted before set().
+    // invalid for other keys and for QVariant properties, whose type depends on the value
+    QMetaType typeOf(const QString &key);
+
+    // in lazy mode nested objects and list elements are only registered once a key below them is used
+    bool isLazy() const;
+    void setLazy(bool lazy);
+
+    // coalesced value changes are collected and flushed at most every notifyInterval msecs,
+    // 0 flushes once per event loop iteration. keys can get a longer interval or opt out
+    bool isCoalescing() const;
+    void setCoalescing(bool coalescing);
+    int notifyInterval() const;
+    void setNotifyInterval(int msecs);
+    void setNotifyInterval(const QString &key, int msecs);
+    void setImmediate(const QString &key, bool immediate);
+
+    // every emitted change gets the next version and goes into a bounded journal, so clients
+    // that come back can catch up with the changes they missed instead of reloading everything.
+    // the journal keeps no objects, changes of values referencing them come with an invalid value
+    quint64 version() const;
+    quint64 version(const QString &key) const;
+    // stats keys are emitted periodically without getting a version, in any thread
+    static bool isVersioned(const QString &key);
+    int journalCapacity() const;
+    void setJournalCapacity(int capacity);
+    QList<Change> changesSince(quint64 version, bool *complete) const;
+
+    // objects living in other threads are never touched from ours: their values are mirrored
+    // into the registry by their notify signals, writes and calls are queued to their thread.
+    // call() cannot wait for those, callAsync() returns the result once it is there
+    QFuture<QVariant> callAsync(const QString &function, const QVariantList &arguments);
+
+    // methods returning QFuture<T> are answered once their future finished. QFuture<QVariant>
+    // works as is, other result types need their conversion registered once
+    template<class T>
+    static void registerFutureType();
+
+    // with a pool, callAsync() runs methods tagged QOPENREMOTE_CONCURRENT in it instead of our thread
+    QThreadPool *threadPool() const;
+    void setThreadPool(QThreadPool *pool);
+
+    // counters and latencies per key, readable and subscribable as "__stats.<key>"
+    RegistryStats &stats();
 
 public slots:
     QVariant call(const QString &function, const QVariantList &arguments);
@@ -31,26 +110,200 @@ public slots:
     void set(const QString &key, const QVariant &value);
     QVariant get(const QString &key);
 
+    // reads every value key matching a prefix ("b.as", "b.as.") or a glob ("b.as.*.integer") in one
+    // pass. object valued keys are left out, their properties are part of the snapshot on their own
+    QVariantMap snapshot(const QString &pattern);
+
+    // writes all values back to back and emits their changes once afterwards. an atomic
+    // batch is rejected as a whole if any key is not writable or a value does not convert
+    bool setBatch(const QVariantMap &values, bool atomic = false);
+
+    // value notifies and relayed signals are only connected while a key has subscribers
+    void subscribe(const QString &key);
+    void unsubscribe(const QString &key);
+
+    void flush();
+
 signals:
-    void signalEmitted(const QString &key, const QVariantList &args); // todo
-    void valueChanged(const QString &key, const QVariant &value);
+    // a subscribed signal key was emitted, args are the signal arguments
+    void signalEmitted(const QString &key, const QVariantList &args);
+    // the version of the change, the registry may have moved on by the time it is delivered
+    void valueChanged(const QString &key, const QVariant &value, quint64 version);
+
+    // object lists report what changed instead of their new value. every delta is a map
+    // with an "op" of "insert" (index, value), "remove" (index) or "move" (from, to)
+    void listChanged(const QString &key, const QVariantList &deltas);
 
 private slots:
-    void registerProperty(const QString &propertyName, QObject *object, const QMetaProperty &property);
-    void registerMethod(const QString &methodName, QObject *object, const QMetaMethod &method);
     void onNotifySignal();
 
 private:
-    QMap<QString, QPair<QObject *, QMetaMethod>> _methods;
-    //QMap<QString, QPair<QObject *, QMetaProperty>> _properties;
-    QMap<QString, std::function<void(const QVariant &)>> _set;
-    QMap<QString, std::function<QVariant()>> _get;
+    // one flat record per key, 32 bytes on 64 bit platforms. what only few keys need lives in
+    // side tables by id: registered values, pending children, throttles, relays and stats.
+    // with the trie node and index entry of the key table a key costs about 120 bytes plus its
+    // characters, a subscribed property key another 4 bytes in the notifier of its object
+    struct Slot
+    {
+        enum Type : quint8 {
+            None,
+            Property,
+            Method,
+            Signal,
+        };
+
+        enum Flag : quint8 {
+            Pinned = 0x01,    // a registered object or list element, gets answer the registered value
+            Remote = 0x02,    // the object lives in another thread, reads are served from its mirror
+            Pending = 0x04,   // lazy mode: the subtree below this key is not registered yet
+            Dirty = 0x08,     // a coalesced change waits for the next flush
+            Immediate = 0x10, // changes are never coalesced
+            Objects = 0x20,   // a list that may hold objects, its notifies stay connected for the element keys
+        };
+
+        QObject *object = nullptr;
+        const ClassDescriptor *descriptor = nullptr;
+        quint64 version = 0;
+        int index = -1; // of the property, method or signal in the descriptor
+        Type type = None;
+        ClassDescriptor::Kind kind = ClassDescriptor::Value;
+        quint8 flags = 0;
+
+        bool is(Flag flag) const { return flags & flag; }
+        void set(Flag flag, bool on) { flags = on ? flags | flag : flags & ~flag; }
+        // values and lists of values are only notified while subscribed
+        bool isPlain() const { return kind == ClassDescriptor::Value || (kind == ClassDescriptor::List && !is(Objects)); }
+    };
 
-    QMap<QPair<QObject *, int>, std::function<void()>> _notify;
-    QMap<QString, std::function<QVariant(const QVariantList &)>> _call;
+    static_assert(sizeof(void *) != 8 || sizeof(Slot) == 32, "slots are meant to fit two per cache line");
 
+    struct Throttle
+    {
+        int interval = 0;
+        qint64 flushed = 0;
+    };
+
+    // objects of other threads die in their thread, our deregistration follows queued, and our
+    // objects may die while pool threads call them. their destroyed signal clears alive right
+    // away, whoever hands them to Qt or calls them from a pool thread holds a read lock meanwhile
+    struct Guard
+    {
+        QReadWriteLock lock;
+        bool alive = true;
+    };
+
+    // everything that has to go when an object goes: the keys it was registered under,
+    // the keys of its properties and methods and the connections to its destroyed signal.
+    // the descriptor the slots of these keys point to lives at least as long
+    struct Ownership
+    {
+        QSet<int> anchors;
+        QSet<int> keys;
+        QMetaObject::Connection destroyed;
+        std::shared_ptr<const ClassDescriptor> descriptor;
+
+        // objects of other threads: the mirror reading their properties in their thread and
+        // the last values it reported, by property index
+        ObjectMirror *mirror = nullptr;
+        QVariantList values;
+
+        // of objects of other threads and of ours once they got a pool call. it stays connected
+        // until the object dies, calls still waiting in the pool hold on to it
+        std::shared_ptr<Guard> guard;
+    };
+
+    struct Policy
+    {
+        bool immediate = false;
+        int interval = 0;
+    };
+
+    void registerProperty(const QString &propertyName, QObject *object, const ClassDescriptor &descriptor, int index);
+    void registerMethod(const QString &methodName, QObject *object, const ClassDescriptor &descriptor, int index);
+    void registerSignal(const QString &signalName, QObject *object, const ClassDescriptor &descriptor, int index);
+    void registerElements(const QString &listName, const QVariantList &elements, int from = 0);
+    void updateElements(int id, const QVariantList &elements);
+    void registerPending(int id, const QVariant &variant);
+    Slot &assign(int id, Slot::Type type, QObject *object, const ClassDescriptor &descriptor, int index);
+
+    int resolve(const QString &key);
+    const MethodInvoker *overload(int id, const QString &function, const QVariantList &arguments) const;
+
+    QVariant read(const Slot &slot) const;
+    bool write(const Slot &slot, const QVariant &value);
+    // queues function to the thread of a remote object, unless the object is gone already
+    bool invokeRemote(QObject *object, const std::function<void()> &function);
+    std::shared_ptr<Guard> guardOf(QObject *object);
+    void expand(int id);
+    void expandSubtree(const QString &prefix);
+
+    void notifyProperty(int id);
+    void notifyProperty(int id, const QVariant &value);
+    bool coalesce(int id);
+    void relaySignal(int id, const QVariantList &arguments);
+    void publish(int id, const QVariant &value);
+    QString record(int id, const QVariant &value);
+    void markDirty(int id);
+    void applyPolicy(int id);
+    void wireNotify(int id);
+    void unwireNotify(int id);
+    void attachNotifier(int id);
+    void detachNotifier(int id);
+    void removeSlot(int id, const Slot &slot);
+
+    RegistryStats::KeyStats *statsOf(int id);
+    QVariantMap statsSnapshot(const QString &pattern) const;
+    void publishStats();
+
+    void own(QObject *object, int id, bool anchor);
+    void disown(QObject *object, int id, bool anchor);
+
+    void updateMirror(QObject *object, const QList<int> &properties, const QVariantList &values);
+
+    KeyTable<Slot> _keys;
+    QHash<int, QVariant> _pinned;
+    QHash<int, QPointer<QObject>> _children;
+    QHash<int, Throttle> _throttles;
+    QHash<int, int> _relays;
+    QHash<int, std::shared_ptr<RegistryStats::KeyStats>> _keyStats;
+    // the keys listening to a notify signal, whatever path they are registered under.
+    // the signal is connected once, as long as there is at least one of them
+    QHash<QPair<QObject *, int>, QList<int>> _notify;
+    QHash<QObject *, Ownership> _objects;
+    QHash<QString, int> _subscriptions;
+    QHash<int, QList<QObject *>> _elements;
+    SignalRelay _relay;
+
+    quint64 _version;
+    int _journalCapacity;
+    int _journalHead;
+    QList<Change> _journal;
+
+    int _transactions;
+    bool _coalescing;
+    int _notifyInterval;
+    QHash<QString, Policy> _policies;
+    QList<int> _dirty;
+    QTimer _flushTimer;
+    QElapsedTimer _clock;
+
+    RegistryStats _stats;
+    QTimer _statsTimer;
+
+    bool _lazy;
+    QThreadPool *_threadPool;
     int _notifierSlotIdx;
     QMetaMethod _notifierSlot;
 };
 
+template<class T>
+void QObjectRegistry::registerFutureType()
+{
+    QMetaType::registerConverter<QFuture<T>, QFuture<QVariant>>([](const QFuture<T> &future) {
+        if constexpr (std::is_void_v<T>)
+            return QFuture<T>{future}.then([] { return QVariant{}; });
+        else
+            return QFuture<T>{future}.then([](const T &value) { return QVariant::fromValue(value); });
+    });
+}
+
 #endif // QOBJECTREGISTRY_H
@@ -0,0 +1,127 @@
+#include "registrylink.h"
+
+#include <utility>
+
+#include "classdescriptor.h"
+#include "json.h"
+#include "qobjectregistry.h"
+
+RegistryLink::RegistryLink(QObjectRegistry &registry)
+    : _registry{registry}
+{
+    moveToThread(registry.thread());
+}
+
+RegistryLink::~RegistryLink()
+{
+    // the hub goes with the registry, it may be gone before us
+    if (_hub)
+        for (const auto &key : std::as_const(_keys))
+            _hub->detach(this, key);
+}
+
+void RegistryLink::subscribe(const QString &key)
+{
+    if (!_hub)
+        _hub = LinkHub::of(_registry);
+
+    if (!_keys.contains(key)) {
+        _keys.insert(key);
+        _hub->attach(this, key);
+    }
+}
+
+void RegistryLink::unsubscribe(const QString &key)
+{
+    if (_keys.remove(key) && _hub)
+        _hub->detach(this, key);
+}
+
+QVariant RegistryLink::detach(const QVariant &value)
+{
+    if (ClassDescriptor::kindOf(value.metaType()) == ClassDescriptor::Value)
+        return value;
+
+    return QVariant::fromValue(JSON::serialize(value));
+}
+
+LinkHub *LinkHub::of(QObjectRegistry &registry)
+{
+    if (const auto hub = registry.findChild<LinkHub *>(QString{}, Qt::FindDirectChildrenOnly))
+        return hub;
+
+    return new LinkHub{registry};
+}
+
+LinkHub::LinkHub(QObjectRegistry &registry)
+    : QObject{&registry}
+{
+    connect(&registry, &QObjectRegistry::valueChanged, this, [this](const QString &key, const QVariant &value, quint64 version) {
+        const auto it = _links.constFind(key);
+
+        if (it == _links.cend())
+            return;
+
+        const auto detached = RegistryLink::detach(value);
+
+        for (const auto link : *it)
+            emit link->valueChanged(key, detached, version);
+    });
+
+    connect(&registry, &QObjectRegistry::listChanged, this, [this](const QString &key, const QVariantList &deltas) {
+        const auto it = _links.constFind(key);
+
+        if (it == _links.cend())
+            return;
+
+        QVariantList detached;
+        detached.reserve(deltas.size());
+
+        // inserts carry the inserted element
+        for (const auto &delta : deltas) {
+            auto map = delta.toMap();
+
+            for (auto entry = map.begin(); entry != map.end(); ++entry)
+                *entry = RegistryLink::detach(*entry);
+
+            detached.append(map);
+        }
+
+        for (const auto link : *it)
+            emit link->listChanged(key, detached);
+    });
+
+    connect(&registry, &QObjectRegistry::signalEmitted, this, [this](const QString &key, const QVariantList &args) {
+        const auto it = _links.constFind(key);
+
+        if (it == _links.cend())
+            return;
+
+        QVariantList detached;
+        detached.reserve(args.size());
+
+        for (const auto &arg : args)
+            detached.append(RegistryLink::detach(arg));
+
+        for (const auto link : *it)
+            emit link->signalEmitted(key, detached);
+    });
+}
+
+void LinkHub::attach(RegistryLink *link, const QString &key)
+{
+    _links[key].append(link);
+}
+
+void LinkHub::detach(RegistryLink *link, const QString &key)
+{
+    const auto it = _links.find(key);
+
+    if (it == _links.end())
+        return;
+
+    it->removeOne(link);
+
+    if (it->isEmpty())
+        _links.erase(it);
+}
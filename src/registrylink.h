@@ -0,0 +1,65 @@
+#ifndef REGISTRYLINK_H
+#define REGISTRYLINK_H
+
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QSet>
+#include <QVariant>
+
+class QObjectRegistry;
+class LinkHub;
+
+/*
+ * forwards the changes of a registry to an adapter of another thread. the link lives
+ * in the thread of the registry, so values referencing objects are serialized there,
+ * where their objects live, and only plain values and json cross over. the version
+ * the registry emitted travels along, the adapter must not ask the registry for it.
+ * a link only forwards the keys it is subscribed to, subscribe() and unsubscribe()
+ * are called in the thread of the registry.
+ */
+class RegistryLink : public QObject
+{
+    Q_OBJECT
+public:
+    explicit RegistryLink(QObjectRegistry &registry);
+    ~RegistryLink() override;
+
+    void subscribe(const QString &key);
+    void unsubscribe(const QString &key);
+
+    // values the adapter can serialize in its own thread
+    static QVariant detach(const QVariant &value);
+
+signals:
+    void valueChanged(const QString &key, const QVariant &value, quint64 version);
+    void listChanged(const QString &key, const QVariantList &deltas);
+    void signalEmitted(const QString &key, const QVariantList &args);
+
+private:
+    QObjectRegistry &_registry;
+    QPointer<LinkHub> _hub;
+    QSet<QString> _keys;
+};
+
+/*
+ * the links of a registry by the keys they are subscribed to, a child of the registry.
+ * it is the only one listening to the registry, every change is looked up once and
+ * detached once for all the links that want it.
+ */
+class LinkHub : public QObject
+{
+    Q_OBJECT
+public:
+    static LinkHub *of(QObjectRegistry &registry);
+
+    void attach(RegistryLink *link, const QString &key);
+    void detach(RegistryLink *link, const QString &key);
+
+private:
+    explicit LinkHub(QObjectRegistry &registry);
+
+    QHash<QString, QList<RegistryLink *>> _links;
+};
+
+#endif // REGISTRYLINK_H
@@ -0,0 +1,124 @@
+#include "registrystats.h"
+
+#include <QLoggingCategory>
+#include <QtAlgorithms>
+
+namespace {
+Q_LOGGING_CATEGORY(self, "stats", QtWarningMsg)
+
+const char *const operationNames[] = {"get", "set", "call", "notify", "send"};
+} // namespace
+
+void RegistryStats::KeyStats::record(Operation operation, qint64 nsecs)
+{
+    const auto bucket = nsecs <= 1 ? 0 : qMin(Buckets - 1, 63 - int(qCountLeadingZeroBits(quint64(nsecs))));
+
+    counts[operation].fetch_add(1, std::memory_order_relaxed);
+    latencies[operation][bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+void RegistryStats::KeyStats::queue(qint64 messages, qint64 bytes)
+{
+    const auto depth = queuedMessages.fetch_add(messages, std::memory_order_relaxed) + messages;
+    queuedBytes.fetch_add(bytes, std::memory_order_relaxed);
+
+    auto peak = queuedPeak.load(std::memory_order_relaxed);
+    while (depth > peak && !queuedPeak.compare_exchange_weak(peak, depth, std::memory_order_relaxed)) {}
+}
+
+QVariantMap RegistryStats::KeyStats::toMap() const
+{
+    QVariantMap map;
+
+    if (const auto peak = queuedPeak.load(std::memory_order_relaxed); peak > 0) {
+        map.insert("queue", QVariantMap{
+            {"messages", queuedMessages.load(std::memory_order_relaxed)},
+            {"bytes", queuedBytes.load(std::memory_order_relaxed)},
+            {"peak", peak},
+        });
+    }
+
+    for (int operation = 0; operation < OperationCount; ++operation) {
+        const auto count = counts[operation].load(std::memory_order_relaxed);
+
+        if (count == 0)
+            continue;
+
+        // trailing empty buckets are left out
+        QVariantList buckets;
+        int used = Buckets;
+
+        while (used > 0 && latencies[operation][used - 1].load(std::memory_order_relaxed) == 0)
+            --used;
+
+        for (int i = 0; i < used; ++i)
+            buckets.append(latencies[operation][i].load(std::memory_order_relaxed));
+
+        map.insert(operationNames[operation], QVariantMap{{"count", count}, {"latency", buckets}});
+    }
+
+    return map;
+}
+
+RegistryStats::RegistryStats()
+    : _enabled{false}
+{}
+
+void RegistryStats::setEnabled(bool enabled)
+{
+    qCInfo(self) << "stats" << (enabled ? "enabled" : "disabled");
+    _enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void RegistryStats::reset()
+{
+    // zeroed in place, the stats handed out before stay valid. queue levels are current, not history
+    QMutexLocker locker{&_mutex};
+
+    for (auto it = _keys.cbegin(); it != _keys.cend(); ++it) {
+        const auto &stats = it.value();
+        stats->queuedPeak.store(stats->queuedMessages.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+        for (auto &count : stats->counts)
+            count.store(0, std::memory_order_relaxed);
+
+        for (auto &latencies : stats->latencies)
+            for (auto &bucket : latencies)
+                bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+std::shared_ptr<RegistryStats::KeyStats> RegistryStats::track(const QString &key)
+{
+    if (!isEnabled())
+        return nullptr;
+
+    QMutexLocker locker{&_mutex};
+    auto &stats = _keys[key];
+
+    if (!stats)
+        stats = std::make_shared<KeyStats>();
+
+    return stats;
+}
+
+void RegistryStats::release(const QString &key)
+{
+    QMutexLocker locker{&_mutex};
+
+    if (const auto stats = _keys.take(key))
+        stats->released.store(true, std::memory_order_relaxed);
+}
+
+QStringList RegistryStats::keys() const
+{
+    QMutexLocker locker{&_mutex};
+    return _keys.keys();
+}
+
+QVariant RegistryStats::value(const QString &key) const
+{
+    QMutexLocker locker{&_mutex};
+    const auto stats = _keys.value(key);
+    return stats ? QVariant{stats->toMap()} : QVariant{};
+}
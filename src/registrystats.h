@@ -0,0 +1,104 @@
+#ifndef REGISTRYSTATS_H
+#define REGISTRYSTATS_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QVariant>
+
+#include <array>
+#include <atomic>
+#include <memory>
+
+/*
+ * per key operation counters and latency histograms. the histograms have fixed power
+ * of two buckets, bucket i counts operations that took [2^i, 2^(i+1)) nanoseconds.
+ * recording is a few relaxed atomic increments, looking up the stats of a key takes
+ * a lock, so hot paths keep the pointer until the key is released. while disabled
+ * nothing is measured at all.
+ */
+class RegistryStats
+{
+public:
+    enum Operation {
+        Get,
+        Set,
+        Call,
+        Notify,
+        Send,
+        OperationCount,
+    };
+
+    static constexpr int Buckets = 32;
+
+    struct KeyStats
+    {
+        std::array<std::atomic<quint64>, OperationCount> counts{};
+        std::array<std::array<std::atomic<quint32>, Buckets>, OperationCount> latencies{};
+
+        // levels instead of counts, the frames waiting in outbound queues and the most there were
+        std::atomic<qint64> queuedMessages{0};
+        std::atomic<qint64> queuedBytes{0};
+        std::atomic<qint64> queuedPeak{0};
+
+        // the key went away, whoever kept these stats tracks the key again when it needs it
+        std::atomic<bool> released{false};
+
+        void record(Operation operation, qint64 nsecs);
+        void queue(qint64 messages, qint64 bytes);
+        QVariantMap toMap() const;
+    };
+
+    // measures from construction to destruction, does nothing without stats
+    class Measurement
+    {
+    public:
+        Measurement(KeyStats *stats, Operation operation);
+        ~Measurement();
+
+    private:
+        KeyStats *_stats;
+        Operation _operation;
+        QElapsedTimer _timer;
+    };
+
+    RegistryStats();
+
+    bool isEnabled() const;
+    void setEnabled(bool enabled);
+    void reset();
+
+    // nullptr while disabled, so callers can hand the result to a Measurement right away
+    std::shared_ptr<KeyStats> track(const QString &key);
+    // drops the stats of a key that is gone, those handed out stay valid for their holders
+    void release(const QString &key);
+
+    QStringList keys() const;
+    QVariant value(const QString &key) const;
+
+private:
+    std::atomic<bool> _enabled;
+    mutable QMutex _mutex;
+    QHash<QString, std::shared_ptr<KeyStats>> _keys;
+};
+
+inline bool RegistryStats::isEnabled() const
+{
+    return _enabled.load(std::memory_order_relaxed);
+}
+
+inline RegistryStats::Measurement::Measurement(KeyStats *stats, Operation operation)
+    : _stats{stats}
+    , _operation{operation}
+{
+    if (_stats)
+        _timer.start();
+}
+
+inline RegistryStats::Measurement::~Measurement()
+{
+    if (_stats)
+        _stats->record(_operation, _timer.nsecsElapsed());
+}
+
+#endif // REGISTRYSTATS_H
@@ -0,0 +1,87 @@
+#include "signalrelay.h"
+
+#include <QLoggingCategory>
+
+namespace {
+Q_LOGGING_CATEGORY(self, "relay", QtWarningMsg)
+}
+
+SignalRelay::SignalRelay(const Callback &callback, QObject *parent)
+    : QObject{parent}
+    , _callback{callback}
+{}
+
+void SignalRelay::reserve(int size)
+{
+    _entries.reserve(size);
+}
+
+int SignalRelay::connectSignal(QObject *sender, const QMetaMethod &signal, int tag, Qt::ConnectionType type)
+{
+    int id;
+
+    if (_free.isEmpty()) {
+        id = _entries.size();
+        _entries.append(Entry{});
+    } else {
+        id = _free.takeLast();
+    }
+
+    auto &entry = _entries[id];
+    entry.tag = tag;
+    entry.parameterTypes.clear();
+
+    for (int i = 0; i < signal.parameterCount(); ++i)
+        entry.parameterTypes.append(signal.parameterMetaType(i));
+
+    // our dynamic slots are numbered after the methods of QObject
+    const auto slot = QObject::staticMetaObject.methodCount() + id;
+    entry.connection = QMetaObject::connect(sender, signal.methodIndex(), this, slot, type);
+
+    if (!entry.connection) {
+        qCWarning(self) << "failed to connect" << signal.methodSignature() << "of" << sender;
+        disconnectSignal(id);
+        return -1;
+    }
+
+    qCDebug(self) << "relay" << signal.methodSignature() << "of" << sender << "as" << id;
+    return id;
+}
+
+void SignalRelay::disconnectSignal(int id)
+{
+    if (id < 0 || id >= _entries.size() || _entries[id].tag < 0)
+        return;
+
+    disconnect(_entries[id].connection);
+    _entries[id] = Entry{};
+
+    // queued emissions already posted still arrive at this id, with the arguments of its old signal.
+    // it is handed out again once they are through, they are ahead of us in the queue
+    QMetaObject::invokeMethod(this, [this, id] { _free.append(id); }, Qt::QueuedConnection);
+}
+
+int SignalRelay::qt_metacall(QMetaObject::Call call, int id, void **arguments)
+{
+    id = QObject::qt_metacall(call, id, arguments);
+
+    if (id < 0 || call != QMetaObject::InvokeMetaMethod)
+        return id;
+
+    if (id >= _entries.size() || _entries[id].tag < 0) {
+        qCDebug(self) << "signal for disconnected relay slot" << id;
+        return -1;
+    }
+
+    // arguments[0] would be the return value, the signal arguments follow
+
+    const auto &entry = _entries[id];
+    QVariantList variants;
+    variants.reserve(entry.parameterTypes.size());
+
+    for (int i = 0; i < entry.parameterTypes.size(); ++i)
+        variants.append(QVariant{entry.parameterTypes[i], arguments[i + 1]});
+
+    _callback(entry.tag, variants);
+    return -1;
+}
@@ -0,0 +1,46 @@
+#ifndef SIGNALRELAY_H
+#define SIGNALRELAY_H
+
+#include <QMetaMethod>
+#include <QObject>
+#include <QVariant>
+
+#include <functional>
+
+/*
+ * forwards arbitrary signals to a single callback. every connected signal gets a
+ * dynamic slot id on this object, emissions arrive in qt_metacall with the raw
+ * argument array and get copied into a QVariantList with the precomputed
+ * parameter types. connecting does not need a functor per signal.
+ *
+ * with a direct connection the callback runs in the thread of the sender, reserve
+ * the slots up front if signals may arrive while more of them get connected.
+ * ids of disconnected signals are reused once the event loop got to them.
+ */
+class SignalRelay : public QObject
+{
+public:
+    using Callback = std::function<void(int tag, const QVariantList &arguments)>;
+
+    explicit SignalRelay(const Callback &callback, QObject *parent = nullptr);
+
+    void reserve(int size);
+    int connectSignal(QObject *sender, const QMetaMethod &signal, int tag, Qt::ConnectionType type = Qt::AutoConnection);
+    void disconnectSignal(int id);
+
+    int qt_metacall(QMetaObject::Call call, int id, void **arguments) override;
+
+private:
+    struct Entry
+    {
+        QMetaObject::Connection connection;
+        QList<QMetaType> parameterTypes;
+        int tag = -1;
+    };
+
+    Callback _callback;
+    QList<Entry> _entries;
+    QList<int> _free;
+};
+
+#endif // SIGNALRELAY_H
@@ -1,40 +1,135 @@
 #include "websocketserver.h"
 
+#include <functional>
+
 #include <QLoggingCategory>
+#include <QTcpServer>
+#include <QThread>
 
-#include <jsonadapter.h>
+#include "websocketworker.h"
 
 namespace {
 Q_LOGGING_CATEGORY(self, "server", QtWarningMsg)
-}
+
+// hands out accepted connections as plain descriptors, a QTcpSocket can only be used in the thread that created it
+class Listener : public QTcpServer
+{
+public:
+    Listener(const std::function<void(qintptr)> &accept, QObject *parent)
+        : QTcpServer{parent}
+        , _accept{accept}
+    {}
+
+protected:
+    void incomingConnection(qintptr descriptor) override { _accept(descriptor); }
+
+private:
+    std::function<void(qintptr)> _accept;
+};
+} // namespace
 
 WebSocketServer::WebSocketServer(QObjectRegistry &registry, QObject *parent)
+    : WebSocketServer{registry, 0, parent}
+{}
+
+WebSocketServer::WebSocketServer(QObjectRegistry &registry, int workers, QObject *parent)
     : QObject{parent}
-    , _registry{registry}
-    , _server{"talking-clock", QWebSocketServer::NonSecureMode}
+    , _listener{new Listener{[this](qintptr descriptor) { dispatch(descriptor); }, this}}
+    , _next{0}
+{
+    for (int i = 0; i < qMax(1, workers); ++i) {
+        auto worker = new WebSocketWorker{registry};
+        QThread *thread = nullptr;
+
+        if (workers > 0) {
+            thread = new QThread{this};
+            thread->setObjectName(QString{"websocket-%1"}.arg(i));
+            worker->moveToThread(thread);
+            connect(thread, &QThread::finished, worker, &QObject::deleteLater);
+            thread->start();
+        } else {
+            worker->setParent(this);
+        }
+
+        // queued from worker threads, so the counts are only ever touched by us
+        connect(worker, &WebSocketWorker::clientConnected, this, [this, i](QWebSocket *client) {
+            _workers[i].clients++;
+            emit clientConnected(client);
+        });
+        connect(worker, &WebSocketWorker::clientDisconnected, this, [this, i] { _workers[i].clients--; });
+
+        _workers.append({thread, worker, 0});
+    }
+
+    qCInfo(self) << "serving clients in" << workers << "worker threads";
+
+    if (!_listener->listen(QHostAddress{"127.0.0.1"}, 21120))
+        qCCritical(self) << "failed to start websocket server:" << _listener->errorString();
+}
+
+WebSocketServer::~WebSocketServer()
+{
+    // workers of other threads and their clients are deleted once their thread finished
+    _listener->close();
+
+    for (const auto &worker : std::as_const(_workers)) {
+        if (worker.thread) {
+            worker.thread->quit();
+            worker.thread->wait();
+        }
+    }
+}
+
+int WebSocketServer::workerCount() const
+{
+    return _workers.first().thread ? int(_workers.size()) : 0;
+}
+
+quint16 WebSocketServer::serverPort() const
+{
+    return _listener->serverPort();
+}
+
+int WebSocketServer::clientCount() const
+{
+    int clients = 0;
+
+    for (const auto &worker : std::as_const(_workers))
+        clients += worker.clients;
+
+    return clients;
+}
+
+void WebSocketServer::setClientBudget(const OutboundQueue::Budget &budget)
 {
-    connect(&_server, &QWebSocketServer::newConnection, this, &WebSocketServer::onNewConnection);
+    for (const auto &worker : std::as_const(_workers)) {
+        const auto target = worker.worker;
+        QMetaObject::invokeMethod(target, [target, budget] { target->setBudget(budget); });
+    }
+}
 
-    if (!_server.listen(QHostAddress{"127.0.0.1"}, 21120))
-        qCCritical(self) << "failed to start websocket server:" << _server.errorString();
+void WebSocketServer::setCoalescingWindow(int window)
+{
+    for (const auto &worker : std::as_const(_workers)) {
+        const auto target = worker.worker;
+        QMetaObject::invokeMethod(target, [target, window] { target->setCoalescingWindow(window); });
+    }
 }
 
-void WebSocketServer::onNewConnection()
+void WebSocketServer::dispatch(qintptr descriptor)
 {
-    if (!_server.hasPendingConnections())
-        return;
+    // the worker with the fewest clients, round robin between equally loaded ones
+    auto best = _next % _workers.size();
 
-    auto socket = _server.nextPendingConnection();
-    auto adapter = new JSONAdapter{_registry, socket};
-    qCInfo(self) << "client connected" << socket;
+    for (int i = 1; i < _workers.size(); ++i) {
+        const auto candidate = (_next + i) % _workers.size();
 
-    emit clientConnected(socket);
+        if (_workers[candidate].clients < _workers[best].clients)
+            best = candidate;
+    }
 
-    connect(socket, &QWebSocket::textMessageReceived, adapter, [adapter](const QString &message) { adapter->handleMessage(message.toUtf8()); });
-    connect(adapter, &JSONAdapter::sendMessage, socket, [socket](const QByteArray &message) { socket->sendTextMessage(message); });
+    _next = int(best) + 1;
 
-    connect(socket, &QWebSocket::disconnected, this, [socket]() {
-        qCInfo(self) << "client disconnected:" << socket;
-        socket->deleteLater();
-    });
+    const auto worker = _workers[best].worker;
+    QMetaObject::invokeMethod(worker, [worker, descriptor] { worker->serve(descriptor); });
 }
@@ -3,26 +3,52 @@
 
 #include <QObject>
 #include <QtWebSockets/QWebSocket>
-#include <QtWebSockets/QWebSocketServer>
 
+#include <outboundqueue.h>
 #include <qobjectregistry.h>
 
+class QTcpServer;
+class QThread;
+class WebSocketWorker;
+
 class WebSocketServer : public QObject
 {
     Q_OBJECT
 public:
     explicit WebSocketServer(QObjectRegistry &registry, QObject *parent = nullptr);
 
+    // spreads the clients over worker threads with their own event loops, each new client goes to
+    // the worker with the fewest. the registry stays in its thread, the only point they all pass
+    WebSocketServer(QObjectRegistry &registry, int workers, QObject *parent = nullptr);
+    ~WebSocketServer() override;
+
+    int workerCount() const;
+    quint16 serverPort() const;
+    // over all workers, as far as their connects and disconnects got to us
+    int clientCount() const;
+
+    // how far each client may fall behind before it is disconnected, for clients connecting from now on
+    void setClientBudget(const OutboundQueue::Budget &budget);
+    // how long messages wait to share a frame with others, in usecs, for clients asking for batches
+    void setCoalescingWindow(int window);
+
 signals:
+    // with workers, the client belongs to the thread of its worker
     void clientConnected(QWebSocket* client);
 
-private slots:
-    void onNewConnection();
-
 private:
-    QObjectRegistry &_registry;
-    QWebSocketServer _server;
-    QList<QWebSocket *> _sockets;
+    struct Worker
+    {
+        QThread *thread; // nullptr for the worker in our thread
+        WebSocketWorker *worker;
+        int clients;
+    };
+
+    void dispatch(qintptr descriptor);
+
+    QTcpServer *_listener;
+    QList<Worker> _workers;
+    int _next;
 };
 
 #endif // WEBSOCKETSERVER_H
@@ -0,0 +1,85 @@
+#include "websocketworker.h"
+
+#include <QLoggingCategory>
+#include <QTcpSocket>
+
+#include <jsonadapter.h>
+
+namespace {
+Q_LOGGING_CATEGORY(self, "server.worker", QtWarningMsg)
+
+// clients asking for this subprotocol talk cbor in binary frames, everyone else json text.
+// the batch variants get arrays of messages, several of them in one frame
+const QString CborSubprotocol{"qopenremote.cbor"};
+const QString JsonSubprotocol{"qopenremote.json"};
+const QString CborBatchSubprotocol{"qopenremote.cbor.batch"};
+const QString JsonBatchSubprotocol{"qopenremote.json.batch"};
+} // namespace
+
+WebSocketWorker::WebSocketWorker(QObjectRegistry &registry)
+    : _registry{registry}
+    , _server{"talking-clock", QWebSocketServer::NonSecureMode, this}
+    , _window{0}
+{
+    // the server never listens, it only upgrades the connections we hand it.
+    // our child, so it moves along when we are moved to a worker thread
+    connect(&_server, &QWebSocketServer::newConnection, this, &WebSocketWorker::onNewConnection);
+    _server.setSupportedSubprotocols({CborBatchSubprotocol, JsonBatchSubprotocol, CborSubprotocol, JsonSubprotocol});
+}
+
+void WebSocketWorker::setBudget(const OutboundQueue::Budget &budget)
+{
+    _budget = budget;
+}
+
+void WebSocketWorker::setCoalescingWindow(int window)
+{
+    _window = window;
+}
+
+void WebSocketWorker::serve(qintptr descriptor)
+{
+    // the server takes ownership of the socket
+    auto socket = new QTcpSocket{};
+
+    if (!socket->setSocketDescriptor(descriptor)) {
+        qCCritical(self) << "failed to take over connection:" << socket->errorString();
+        delete socket;
+        return;
+    }
+
+    _server.handleConnection(socket);
+}
+
+void WebSocketWorker::onNewConnection()
+{
+    while (_server.hasPendingConnections()) {
+        auto socket = _server.nextPendingConnection();
+        const auto subprotocol = socket->subprotocol();
+        const auto cbor = subprotocol == CborSubprotocol || subprotocol == CborBatchSubprotocol;
+        const auto batch = subprotocol == CborBatchSubprotocol || subprotocol == JsonBatchSubprotocol;
+        auto adapter = new JSONAdapter{_registry, cbor ? JSONAdapter::Cbor : JSONAdapter::Json, socket};
+        const auto name = thread()->objectName();
+        auto queue = new OutboundQueue{socket, cbor, _budget, &_registry.stats(), name.isEmpty() ? "websocket" : name};
+        qCInfo(self) << "client connected" << socket << "in" << thread() << (cbor ? "speaking cbor" : "speaking json") << (batch ? "in batches" : "");
+
+        if (batch)
+            queue->setCoalescing(_window);
+
+        emit clientConnected(socket);
+
+        // never straight to the socket, a slow client would buffer without bounds
+        connect(adapter, &JSONAdapter::sendMessage, queue, &OutboundQueue::send);
+
+        if (cbor)
+            connect(socket, &QWebSocket::binaryMessageReceived, adapter, &JSONAdapter::handleMessage);
+        else
+            connect(socket, &QWebSocket::textMessageReceived, adapter, [adapter](const QString &message) { adapter->handleMessage(message.toUtf8()); });
+
+        connect(socket, &QWebSocket::disconnected, this, [this, socket]() {
+            qCInfo(self) << "client disconnected:" << socket;
+            socket->deleteLater();
+            emit clientDisconnected();
+        });
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef WEBSOCKETWORKER_H
+#define WEBSOCKETWORKER_H
+
+#include <QObject>
+#include <QtWebSockets/QWebSocket>
+#include <QtWebSockets/QWebSocketServer>
+
+#include <outboundqueue.h>
+#include <qobjectregistry.h>
+
+/*
+ * serves the connections handed to it with one JSONAdapter each, in the thread it
+ * lives in. workers of other threads than the registry's never touch it directly,
+ * their adapters queue everything over to the registry thread. the outbound queues
+ * of all its clients add up to the stats of "websocket", or the name of its thread.
+ */
+class WebSocketWorker : public QObject
+{
+    Q_OBJECT
+public:
+    explicit WebSocketWorker(QObjectRegistry &registry);
+
+    // applies to clients connecting from now on
+    void setBudget(const OutboundQueue::Budget &budget);
+    // for clients of the batch subprotocols, in usecs. 0 packs what one event loop iteration sent
+    void setCoalescingWindow(int window);
+
+public slots:
+    // takes over an accepted tcp connection and upgrades it, in our thread
+    void serve(qintptr descriptor);
+
+signals:
+    void clientConnected(QWebSocket *client);
+    void clientDisconnected();
+
+private slots:
+    void onNewConnection();
+
+private:
+    QObjectRegistry &_registry;
+    QWebSocketServer _server;
+    OutboundQueue::Budget _budget;
+    int _window;
+};
+
+#endif // WEBSOCKETWORKER_H
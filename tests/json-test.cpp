@@ -1,4 +1,7 @@
+#include <limits>
+
 #include <QJsonArray>
+#include <QJsonDocument>
 #include <QJsonObject>
 #include <QtTest/QTest>
 
@@ -96,6 +99,18 @@ private:
     QList<A *> m_as;
 };
 
+class Switch
+{
+    Q_GADGET
+
+public:
+    enum State {
+        Off,
+        On,
+    };
+    Q_ENUM(State)
+};
+
 class JSONTest : public QObject
 {
     Q_OBJECT
@@ -140,6 +155,107 @@ private slots:
         }
     }
 
+    void testTypedValues()
+    {
+        // numbers arrive as doubles, the target type decides
+
+        auto integer = JSON::deserialize(QJsonValue{3.0}, QMetaType::fromType<int>());
+        QCOMPARE(integer.metaType(), QMetaType::fromType<int>());
+        QCOMPARE(integer.toInt(), 3);
+
+        // but are not rounded or cut off into one
+
+        QCOMPARE(JSON::deserialize(QJsonValue{2.5}, QMetaType::fromType<int>()).metaType(), QMetaType::fromType<double>());
+        QCOMPARE(JSON::deserialize(QJsonValue{1e10}, QMetaType::fromType<int>()).metaType(), QMetaType::fromType<double>());
+        QCOMPARE(JSON::deserialize(QJsonValue{-1.0}, QMetaType::fromType<uint>()).metaType(), QMetaType::fromType<double>());
+        QCOMPARE(JSON::deserialize(QJsonValue{0.5}, QMetaType::fromType<bool>()).metaType(), QMetaType::fromType<double>());
+        QCOMPARE(JSON::deserialize(QJsonValue{2.5}, QMetaType::fromType<float>()).toFloat(), 2.5f);
+
+        // enums by key and by value
+
+        QCOMPARE(JSON::deserialize<Switch::State>(QJsonValue{"On"}), Switch::On);
+        QCOMPARE(JSON::deserialize<Switch::State>(QJsonValue{1}), Switch::On);
+    }
+
+    void testWrite_data()
+    {
+        QTest::addColumn<QVariant>("value");
+        QTest::addColumn<QByteArray>("json");
+
+        QTest::newRow("control characters") << QVariant{QString{"a\x01\x1f\n\r\t\b"}} << QByteArray{R"("a\u0001\u001f\n\r\t\u0008")"};
+        QTest::newRow("quotes and backslashes") << QVariant{QString{R"(say "hi" \ bye)"}} << QByteArray{R"("say \"hi\" \\ bye")"};
+        QTest::newRow("non ascii") << QVariant{QString::fromUtf8("grüße, €")} << QByteArray{"\"grüße, €\""};
+        QTest::newRow("surrogate pair") << QVariant{QString::fromUtf8("a\xF0\x9F\x98\x80""b\xF0\x9F\x91\x8D")} << QByteArray{"\"a\xF0\x9F\x98\x80""b\xF0\x9F\x91\x8D\""};
+        QTest::newRow("empty string") << QVariant{QString{""}} << QByteArray{R"("")"};
+
+        QTest::newRow("nan") << QVariant{std::numeric_limits<double>::quiet_NaN()} << QByteArray{"null"};
+        QTest::newRow("inf") << QVariant{std::numeric_limits<double>::infinity()} << QByteArray{"null"};
+        QTest::newRow("-inf") << QVariant{-std::numeric_limits<double>::infinity()} << QByteArray{"null"};
+        QTest::newRow("float inf") << QVariant{std::numeric_limits<float>::infinity()} << QByteArray{"null"};
+
+        QTest::newRow("int min") << QVariant{std::numeric_limits<int>::min()} << QByteArray{"-2147483648"};
+        QTest::newRow("uint max") << QVariant{std::numeric_limits<uint>::max()} << QByteArray{"4294967295"};
+        QTest::newRow("qint64 min") << QVariant{std::numeric_limits<qint64>::min()} << QByteArray{"-9223372036854775808"};
+        QTest::newRow("quint64 max") << QVariant{std::numeric_limits<quint64>::max()} << QByteArray{"18446744073709551615"};
+
+        QTest::newRow("bool") << QVariant{true} << QByteArray{"true"};
+    }
+
+    void testWrite()
+    {
+        QFETCH(QVariant, value);
+        QFETCH(QByteArray, json);
+
+        QByteArray written;
+        QVERIFY(JSON::write(written, value));
+        QCOMPARE(written, json);
+
+        // what is written has to be read back the same by a regular parser
+        if (value.typeId() == QMetaType::QString) {
+            const auto parsed = QJsonDocument::fromJson("[" + written + "]");
+            QVERIFY(parsed.isArray());
+            QCOMPARE(parsed.array().at(0).toString(), value.toString());
+        }
+    }
+
+    void testWriteDoubles_data()
+    {
+        QTest::addColumn<double>("value");
+
+        QTest::newRow("zero") << 0.0;
+        QTest::newRow("integral") << 3.0;
+        QTest::newRow("tenth") << 0.1;
+        QTest::newRow("third") << 1.0 / 3;
+        QTest::newRow("negative") << -2.5e-8;
+        QTest::newRow("large") << 1.7976931348623157e308;
+        QTest::newRow("smallest normal") << 2.2250738585072014e-308;
+        QTest::newRow("beyond int64") << 1e19;
+    }
+
+    void testWriteDoubles()
+    {
+        QFETCH(double, value);
+
+        QByteArray written;
+        QVERIFY(JSON::write(written, value));
+
+        // the shortest text that reads back as the same double
+        const auto parsed = QJsonDocument::fromJson("[" + written + "]");
+        QVERIFY2(parsed.isArray(), written.constData());
+        // exactly, QCOMPARE would compare doubles fuzzily
+        QVERIFY2(parsed.array().at(0).toDouble() == value, written.constData());
+        QVERIFY2(written.toDouble() == value, written.constData());
+    }
+
+    void testWriteUnsupported()
+    {
+        // everything else goes through serialize()
+        QByteArray written;
+        QVERIFY(!JSON::write(written, QVariant{QVariantList{1, 2}}));
+        QVERIFY(!JSON::write(written, QVariant{}));
+        QVERIFY(written.isEmpty());
+    }
+
     void testSimpleQObject()
     {
         A obj;
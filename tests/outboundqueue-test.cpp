@@ -0,0 +1,166 @@
+#include <memory>
+
+#include <QCborArray>
+#include <QCborMap>
+#include <QCborValue>
+#include <QHostAddress>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTcpSocket>
+#include <QtTest/QSignalSpy>
+#include <QtTest/QTest>
+#include <QtWebSockets/QWebSocket>
+#include <QtWebSockets/QWebSocketServer>
+
+#include "outboundqueue.h"
+
+class OutboundQueueTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void supersededNotifies()
+    {
+        QWebSocketServer server{"outboundqueue-test", QWebSocketServer::NonSecureMode};
+        QVERIFY(server.listen(QHostAddress::LocalHost));
+
+        QWebSocket client{};
+        QStringList received;
+        connect(&client, &QWebSocket::textMessageReceived, this, [&received](const QString &message) { received.append(message); });
+        client.open(QUrl{QString{"ws://127.0.0.1:%1"}.arg(server.serverPort())});
+
+        QTRY_VERIFY(server.hasPendingConnections());
+        std::unique_ptr<QWebSocket> socket{server.nextPendingConnection()};
+        QTRY_COMPARE(client.state(), QAbstractSocket::ConnectedState);
+
+        RegistryStats stats{};
+        auto queue = new OutboundQueue{socket.get(), false, {}, &stats, "queue"};
+
+        // nothing is written before the event loop runs again, so the socket stays behind the first frame
+        const QByteArray blocker(70 * 1024, 'x');
+        queue->send(blocker);
+        QCOMPARE(queue->depth(), 0);
+
+        // enabled with a queue already there, its frames count from now on
+        stats.setEnabled(true);
+
+        queue->send("n1", "a");
+        queue->send("r1");
+        queue->send("n2", "a");
+        queue->send("n3", "b");
+        QCOMPARE(queue->depth(), 3);
+
+        // enough superseded frames to compact the queue, the positions of the others have to survive
+        for (int i = 0; i < 200; ++i)
+            queue->send(QByteArray::number(i), "c");
+
+        queue->send("n4", "a");
+        QCOMPARE(queue->depth(), 4);
+        QCOMPARE(stats.value("queue").toMap()["queue"].toMap()["messages"].toInt(), 4);
+
+        QTRY_COMPARE(received.size(), 5);
+        QCOMPARE(received, (QStringList{QString::fromLatin1(blocker), "r1", "n3", "199", "n4"}));
+        QCOMPARE(queue->depth(), 0);
+        QCOMPARE(stats.value("queue").toMap()["queue"].toMap()["messages"].toInt(), 0);
+    }
+
+    void packedFrames_data()
+    {
+        QTest::addColumn<bool>("binary");
+        QTest::addColumn<int>("window");
+
+        QTest::newRow("json per iteration") << false << 0;
+        QTest::newRow("cbor per iteration") << true << 0;
+        QTest::newRow("json in a window") << false << 50000;
+        QTest::newRow("cbor in a window") << true << 50000;
+    }
+
+    void packedFrames()
+    {
+        QFETCH(bool, binary);
+        QFETCH(int, window);
+
+        QWebSocketServer server{"outboundqueue-test", QWebSocketServer::NonSecureMode};
+        QVERIFY(server.listen(QHostAddress::LocalHost));
+
+        QWebSocket client{};
+        QList<QByteArray> received;
+        connect(&client, &QWebSocket::textMessageReceived, this, [&received](const QString &message) { received.append(message.toUtf8()); });
+        connect(&client, &QWebSocket::binaryMessageReceived, this, [&received](const QByteArray &message) { received.append(message); });
+        client.open(QUrl{QString{"ws://127.0.0.1:%1"}.arg(server.serverPort())});
+
+        QTRY_VERIFY(server.hasPendingConnections());
+        std::unique_ptr<QWebSocket> socket{server.nextPendingConnection()};
+        QTRY_COMPARE(client.state(), QAbstractSocket::ConnectedState);
+
+        auto queue = new OutboundQueue{socket.get(), binary, {}};
+        queue->setCoalescing(window);
+
+        const auto message = [binary](int i) {
+            return binary ? QCborMap{{QLatin1String{"id"}, i}}.toCborValue().toCbor() : QJsonDocument{QJsonObject{{"id", i}}}.toJson();
+        };
+
+        queue->send(message(0));
+        queue->send(message(1), "a");
+
+        // a window spans event loop iterations
+        if (window > 0) {
+            QTest::qWait(10);
+            QVERIFY(received.isEmpty());
+        }
+
+        queue->send(message(2));
+
+        QTRY_COMPARE(received.size(), 1);
+
+        QList<int> ids;
+
+        if (binary) {
+            const auto array = QCborValue::fromCbor(received.first()).toArray();
+            for (const auto &value : array)
+                ids.append(int(value.toMap()[QLatin1String{"id"}].toInteger()));
+        } else {
+            const auto array = QJsonDocument::fromJson(received.first()).array();
+            for (const auto &value : array)
+                ids.append(value.toObject()["id"].toInt());
+        }
+
+        QCOMPARE(ids, (QList<int>{0, 1, 2}));
+    }
+
+    void overBudget()
+    {
+        QWebSocketServer server{"outboundqueue-test", QWebSocketServer::NonSecureMode};
+        QVERIFY(server.listen(QHostAddress::LocalHost));
+
+        // a client that never reads, once the buffers of the system are full nothing drains anymore
+        QTcpSocket client{};
+        client.setReadBufferSize(1024);
+        client.connectToHost(QHostAddress::LocalHost, server.serverPort());
+        QVERIFY(client.waitForConnected());
+        client.write("GET / HTTP/1.1\r\n"
+                     "Host: 127.0.0.1\r\n"
+                     "Upgrade: websocket\r\n"
+                     "Connection: Upgrade\r\n"
+                     "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                     "Sec-WebSocket-Version: 13\r\n\r\n");
+
+        QTRY_VERIFY(server.hasPendingConnections());
+        std::unique_ptr<QWebSocket> socket{server.nextPendingConnection()};
+        QSignalSpy disconnected{socket.get(), &QWebSocket::disconnected};
+
+        auto queue = new OutboundQueue{socket.get(), false, {1024 * 1024, 10000, 100}};
+        const QByteArray frame(1024 * 1024, 'x');
+
+        for (int i = 0; i < 32; ++i)
+            queue->send(frame);
+
+        QCOMPARE(queue->depth(), 31);
+        QTRY_COMPARE_WITH_TIMEOUT(disconnected.size(), 1, 10000);
+    }
+};
+
+#include "outboundqueue-test.moc"
+
+QTEST_MAIN(OutboundQueueTest)
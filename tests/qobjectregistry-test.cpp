@@ -1,5 +1,16 @@
+#include <memory>
+
+#include <QCborMap>
+#include <QCborValue>
+#include <QJsonDocument>
+#include <QPromise>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+#include <QtTest/QSignalSpy>
 #include <QtTest/QTest>
 
+#include "jsonadapter.h"
 #include "qobjectregistry.h"
 
 class A : public QObject
@@ -37,19 +48,44 @@ public:
         emit numbersChanged();
     }
 
+    QThread *squaredIn() const { return m_squaredIn; }
+
 public slots:
-    QString ping() { return "pong"; };
+    QString ping()
+    {
+        emit pinged("pong");
+        return "pong";
+    };
+    int add(int x, int y) { return x + y; };
+    QString echo(const QVariant &value, const QString &suffix = "!") { return value.toString() + suffix; };
+
+    QFuture<QString> later()
+    {
+        QPromise<QString> promise;
+        promise.start();
+        promise.addResult("later");
+        promise.finish();
+        return promise.future();
+    };
+
+    QOPENREMOTE_CONCURRENT int square(int x)
+    {
+        m_squaredIn = QThread::currentThread();
+        return x * x;
+    };
 
 signals:
     void integerChanged();
     void stringChanged();
 
     void numbersChanged();
+    void pinged(const QString &message);
 
 private:
     int m_integer;
     QString m_string;
     QList<int> m_numbers;
+    QThread *m_squaredIn = nullptr;
 };
 
 class B : public QObject
@@ -86,6 +122,20 @@ private:
     QList<A *> m_as;
 };
 
+// a property and a signal of the same name, like pressed of a MouseArea
+class C : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool pressed READ isPressed NOTIFY pressedChanged FINAL)
+
+public:
+    bool isPressed() const { return true; }
+
+signals:
+    void pressedChanged();
+    void pressed(int button);
+};
+
 class QObjectRegistryTest : public QObject
 {
     Q_OBJECT
@@ -119,9 +169,16 @@ private slots:
         QCOMPARE(registry.get("b.a.integer").toInt(), 2112);
         QCOMPARE(registry.get("b.a.string").toString(), "rocks!");
 
+        // the keys below follow the object of the property
         b.setA(nullptr);
-        QCOMPARE(registry.get("b.a"), QVariant::fromValue(&a));
-        QCOMPARE(registry.get("b.a.string"), a.string());
+        QCOMPARE(registry.get("b.a").value<A *>(), nullptr);
+        QVERIFY(registry.keys("b.a.").isEmpty());
+
+        A other{};
+        other.setInteger(5);
+        b.setA(&other);
+        QCOMPARE(registry.get("b.a"), QVariant::fromValue(&other));
+        QCOMPARE(registry.get("b.a.integer").toInt(), 5);
     }
 
     void simpleListRead()
@@ -173,6 +230,727 @@ private slots:
         QCOMPARE(registry.get("b.as.2.string"), "i am 2");
         QCOMPARE(registry.get("b.as.2.integer"), 2);
     }
+
+    void simpleCall()
+    {
+        QObjectRegistry registry{};
+
+        A a{};
+        registry.registerObject("a", &a);
+
+        QCOMPARE(registry.call("a.ping", {}), "pong");
+        QCOMPARE(registry.call("a.add", {1.0, 2.0}), 3);
+        QCOMPARE(registry.call("a.echo", {"hello"}), "hello!");
+        QCOMPARE(registry.call("a.echo", {"hello", "?"}), "hello?");
+        QCOMPARE(registry.call("a.add", {1}), QVariant{});
+
+        QVERIFY(registry.keys("a.deleteLater").isEmpty());
+        QCOMPARE(registry.call("a.deleteLater", {}), QVariant{});
+        QCOMPARE(registry.call("a.ping", {}), "pong");
+    }
+
+    void sharedDescriptor()
+    {
+        A a1{};
+        A a2{};
+
+        const auto descriptor = ClassDescriptor::forMetaObject(a1.metaObject());
+        QCOMPARE(descriptor.get(), ClassDescriptor::forMetaObject(a2.metaObject()).get());
+
+        const auto b = ClassDescriptor::forMetaObject(&B::staticMetaObject);
+        const auto &properties = b->properties();
+        const auto a = std::find_if(properties.cbegin(), properties.cend(), [](const auto &p) { return p.name == "a"; });
+        const auto as = std::find_if(properties.cbegin(), properties.cend(), [](const auto &p) { return p.name == "as"; });
+
+        QVERIFY(a != properties.cend() && as != properties.cend());
+        QCOMPARE(a->kind, ClassDescriptor::Object);
+        QCOMPARE(as->kind, ClassDescriptor::List);
+    }
+
+    void lazyRead()
+    {
+        QObjectRegistry registry{};
+        registry.setLazy(true);
+
+        A a1{};
+        a1.setInteger(1);
+
+        A a2{};
+        a2.setString("i am 2");
+
+        B b{};
+        b.setA(&a1);
+        b.setAs({&a1, &a2});
+        registry.registerObject("b", &b);
+
+        QVERIFY(registry.keys("b.a.").isEmpty());
+        QVERIFY(registry.keys("b.as.").isEmpty());
+
+        QCOMPARE(registry.get("b.a.integer"), 1);
+        QCOMPARE(registry.get("b.as.1.string"), "i am 2");
+
+        QVERIFY(registry.keys("b.a.").contains("b.a.integer"));
+        QVERIFY(registry.keys("b.as.").contains("b.as.1.string"));
+        QVERIFY(!registry.keys("b.as.").contains("b.as.0.string"));
+    }
+
+    void subscribedNotify()
+    {
+        QObjectRegistry registry{};
+
+        A a{};
+        registry.registerObject("a", &a);
+
+        QSignalSpy spy{&registry, &QObjectRegistry::valueChanged};
+
+        a.setInteger(1);
+        QCOMPARE(spy.size(), 0);
+
+        registry.subscribe("a.integer");
+        registry.subscribe("a.integer");
+        a.setInteger(2);
+        QCOMPARE(spy.size(), 1);
+
+        // along with the version the change got
+        const auto change = spy.takeFirst();
+        QCOMPARE(change.at(0), "a.integer");
+        QCOMPARE(change.at(2).toULongLong(), registry.version("a.integer"));
+
+        registry.unsubscribe("a.integer");
+        a.setInteger(3);
+        QCOMPARE(spy.size(), 1);
+
+        registry.unsubscribe("a.integer");
+        spy.clear();
+        a.setInteger(4);
+        QCOMPARE(spy.size(), 0);
+
+        // lists of plain values follow their subscriptions too
+        a.setNumbers({1});
+        QCOMPARE(spy.size(), 0);
+
+        registry.subscribe("a.numbers");
+        a.setNumbers({1, 2});
+        QCOMPARE(spy.size(), 1);
+        QCOMPARE(spy.takeFirst().at(0), "a.numbers");
+    }
+
+    void aliasedNotify()
+    {
+        QObjectRegistry registry{};
+
+        A a{};
+        registry.registerObject("a", &a);
+        registry.registerObject("alias", &a);
+        registry.subscribe("a.integer");
+        registry.subscribe("alias.integer");
+
+        QSignalSpy spy{&registry, &QObjectRegistry::valueChanged};
+
+        a.setInteger(1);
+        QCOMPARE(spy.size(), 2);
+        QCOMPARE(QSet<QString>({spy[0].at(0).toString(), spy[1].at(0).toString()}), QSet<QString>({"a.integer", "alias.integer"}));
+
+        registry.unsubscribe("a.integer");
+        spy.clear();
+        a.setInteger(2);
+        QCOMPARE(spy.size(), 1);
+        QCOMPARE(spy.takeFirst().at(0), "alias.integer");
+
+        registry.deregisterObject("alias");
+        a.setInteger(3);
+        QCOMPARE(spy.size(), 0);
+    }
+
+    void coalescedNotify()
+    {
+        QObjectRegistry registry{};
+        registry.setCoalescing(true);
+
+        A a{};
+        registry.registerObject("a", &a);
+        registry.subscribe("a.integer");
+        registry.subscribe("a.string");
+        registry.setImmediate("a.string", true);
+
+        QSignalSpy spy{&registry, &QObjectRegistry::valueChanged};
+
+        for (int i = 0; i < 1000; ++i)
+            a.setInteger(i);
+
+        a.setString("now");
+        QCOMPARE(spy.size(), 1);
+        QCOMPARE(spy.takeFirst().at(1), "now");
+
+        QTRY_COMPARE(spy.size(), 1);
+        QCOMPARE(spy.first().at(0), "a.integer");
+        QCOMPARE(spy.first().at(1), 999);
+    }
+
+    void objectListDelta()
+    {
+        QObjectRegistry registry{};
+
+        A a1{};
+        a1.setInteger(1);
+        A a2{};
+        a2.setInteger(2);
+        A a3{};
+        a3.setInteger(3);
+
+        B b{};
+        b.setAs({&a1, &a2});
+        registry.registerObject("b", &b);
+
+        QSignalSpy spy{&registry, &QObjectRegistry::listChanged};
+
+        b.setAs({&a1, &a2, &a3});
+        QCOMPARE(spy.size(), 1);
+
+        auto deltas = spy.takeFirst().at(1).toList();
+        QCOMPARE(deltas.size(), 1);
+        QCOMPARE(deltas[0].toMap()["op"], "insert");
+        QCOMPARE(deltas[0].toMap()["index"], 2);
+        QCOMPARE(registry.get("b.as.2.integer"), 3);
+
+        b.setAs({&a3, &a1});
+        QCOMPARE(spy.size(), 1);
+
+        deltas = spy.takeFirst().at(1).toList();
+        QCOMPARE(deltas.size(), 2);
+        QCOMPARE(deltas[0].toMap()["op"], "remove");
+        QCOMPARE(deltas[0].toMap()["index"], 1);
+        QCOMPARE(deltas[1].toMap()["op"], "move");
+        QCOMPARE(deltas[1].toMap()["from"], 1);
+        QCOMPARE(deltas[1].toMap()["to"], 0);
+
+        QCOMPARE(registry.get("b.as.0.integer"), 3);
+        QCOMPARE(registry.get("b.as.1.integer"), 1);
+        QVERIFY(registry.keys("b.as.2").isEmpty());
+    }
+
+    void destroyedObject()
+    {
+        QObjectRegistry registry{};
+
+        auto a1 = new A{};
+        auto a2 = new A{};
+        a2->setInteger(2);
+
+        B b{};
+        b.setAs({a1, a2});
+        registry.registerObject("b", &b);
+        registry.registerObject("a", a2);
+
+        QVERIFY(!registry.keys("b.as.0.").isEmpty());
+        delete a1;
+        QVERIFY(registry.keys("b.as.0").isEmpty());
+        QCOMPARE(registry.get("b.as.1.integer"), 2);
+
+        registry.deregisterObject(a2);
+        QVERIFY(registry.keys("a").isEmpty());
+        QVERIFY(registry.keys("b.as.1").isEmpty());
+        QVERIFY(!registry.methods().isEmpty());
+
+        delete a2;
+    }
+
+    void snapshot()
+    {
+        QObjectRegistry registry{};
+
+        A a1{};
+        a1.setInteger(1);
+        a1.setString("one");
+        A a2{};
+        a2.setInteger(2);
+
+        B b{};
+        b.setA(&a1);
+        b.setAs({&a1, &a2});
+        registry.registerObject("b", &b);
+
+        const auto a = registry.snapshot("b.a");
+        QCOMPARE(a.value("b.a.integer"), 1);
+        QCOMPARE(a.value("b.a.string"), "one");
+        QVERIFY(a.contains("b.a.numbers"));
+        QVERIFY(!a.contains("b.a"));
+        QVERIFY(!a.contains("b.as"));
+
+        const auto integers = registry.snapshot("b.as.*.integer");
+        QCOMPARE(integers.size(), 2);
+        QCOMPARE(integers.value("b.as.0.integer"), 1);
+        QCOMPARE(integers.value("b.as.1.integer"), 2);
+
+        // lazily registered subtrees are expanded first
+        QObjectRegistry lazy{};
+        lazy.setLazy(true);
+        lazy.registerObject("b", &b);
+
+        QCOMPARE(lazy.snapshot("b.a").value("b.a.integer"), 1);
+        QCOMPARE(lazy.snapshot("b.as.*.integer"), integers);
+    }
+
+    void batchSet()
+    {
+        QObjectRegistry registry{};
+
+        A a{};
+        a.setInteger(0);
+        registry.registerObject("a", &a);
+        registry.subscribe("a.integer");
+        registry.subscribe("a.string");
+
+        QSignalSpy spy{&registry, &QObjectRegistry::valueChanged};
+
+        QVERIFY(registry.setBatch({{"a.integer", "5"}, {"a.string", "five"}}));
+        QCOMPARE(a.integer(), 5);
+        QCOMPARE(a.string(), "five");
+        QCOMPARE(spy.size(), 2);
+
+        spy.clear();
+        QVERIFY(!registry.setBatch({{"a.integer", 7}, {"a.nothing", 1}}, true));
+        QCOMPARE(a.integer(), 5);
+        QCOMPARE(spy.size(), 0);
+
+        QVERIFY(!registry.setBatch({{"a.integer", 7}, {"a.nothing", 1}}));
+        QCOMPARE(a.integer(), 7);
+        QCOMPARE(spy.size(), 1);
+    }
+
+    void changeJournal()
+    {
+        QObjectRegistry registry{};
+        registry.setJournalCapacity(4);
+
+        A a{};
+        a.setInteger(0);
+        registry.registerObject("a", &a);
+        registry.subscribe("a.integer");
+        registry.subscribe("a.string");
+
+        const auto version = registry.version();
+        bool complete;
+
+        a.setInteger(1);
+        a.setString("x");
+        a.setInteger(2);
+
+        QCOMPARE(registry.version(), version + 3);
+        QCOMPARE(registry.version("a.integer"), version + 3);
+
+        auto changes = registry.changesSince(version, &complete);
+        QVERIFY(complete);
+        QCOMPARE(changes.size(), 2);
+        QCOMPARE(changes[0].key, "a.integer");
+        QCOMPARE(changes[0].value, 2);
+        QCOMPARE(changes[1].key, "a.string");
+
+        a.setInteger(3);
+        a.setInteger(4);
+
+        changes = registry.changesSince(version, &complete);
+        QVERIFY(!complete);
+
+        changes = registry.changesSince(registry.version(), &complete);
+        QVERIFY(complete);
+        QVERIFY(changes.isEmpty());
+
+        // objects are not journaled, they may be gone by the time a client catches up
+        QObjectRegistry objects{};
+
+        A a1{};
+        B b{};
+        objects.registerObject("b", &b);
+
+        const auto before = objects.version();
+        b.setA(&a1);
+        b.setAs({&a1});
+
+        changes = objects.changesSince(before, &complete);
+        QVERIFY(complete);
+
+        const auto a = std::find_if(changes.cbegin(), changes.cend(), [](const auto &change) { return change.key == "b.a"; });
+        const auto as = std::find_if(changes.cbegin(), changes.cend(), [](const auto &change) { return change.key == "b.as"; });
+        QVERIFY(a != changes.cend() && as != changes.cend());
+        QVERIFY(!a->value.isValid());
+        QVERIFY(!as->value.isValid());
+    }
+
+    void resumeSession()
+    {
+        QObjectRegistry registry{};
+
+        A a{};
+        a.setInteger(1);
+        registry.registerObject("a", &a);
+
+        const auto reply = [](const QSignalSpy &spy, int i) { return QJsonDocument::fromJson(spy[i][0].toByteArray()).object(); };
+
+        auto adapter = std::make_unique<JSONAdapter>(registry);
+        QSignalSpy spy{adapter.get(), &JSONAdapter::sendMessage};
+        adapter->handleMessage(R"({"type": "subscribe", "key": "a.integer"})");
+        adapter->handleMessage(R"({"type": "session", "key": ""})");
+
+        QCOMPARE(spy.size(), 2);
+        const auto session = reply(spy, 1);
+        QCOMPARE(session["type"].toString(), "session");
+
+        // changed while the client is away, the session keeps the key subscribed. the
+        // string is journaled for someone else
+        adapter.reset();
+        registry.subscribe("a.string");
+        a.setInteger(2);
+        a.setString("away");
+
+        JSONAdapter resumed{registry};
+        QSignalSpy resumedSpy{&resumed, &JSONAdapter::sendMessage};
+        resumed.handleMessage(QJsonDocument{QJsonObject{
+            {"type", "resume"},
+            {"key", session["key"]},
+            {"value", session["value"]},
+        }}.toJson());
+
+        // only the subscribed key, not the string changed meanwhile
+        QCOMPARE(resumedSpy.size(), 2);
+        QCOMPARE(reply(resumedSpy, 0)["key"].toString(), "a.integer");
+        QCOMPARE(reply(resumedSpy, 0)["value"].toInt(), 2);
+        QCOMPARE(reply(resumedSpy, 1)["type"].toString(), "session");
+
+        a.setInteger(3);
+        QCOMPARE(resumedSpy.size(), 3);
+        QCOMPARE(reply(resumedSpy, 2)["value"].toInt(), 3);
+    }
+
+    void prefixDeregister()
+    {
+        QObjectRegistry registry{};
+
+        A a{};
+        B b{};
+        b.setA(&a);
+        registry.registerObject("b", &b);
+
+        QVERIFY(registry.keys("b.a.").contains("b.a.integer"));
+        QVERIFY(!registry.keys("b.a.").contains("b.a"));
+        QVERIFY(registry.keys("b.a").contains("b.a"));
+
+        registry.deregisterObject("b.a");
+
+        QVERIFY(registry.keys("b.a").isEmpty());
+        QVERIFY(registry.keys().contains("b.as"));
+        QCOMPARE(registry.get("b.a.integer"), QVariant{});
+    }
+
+    void relayedSignal()
+    {
+        QObjectRegistry registry{};
+        QSignalSpy spy{&registry, &QObjectRegistry::signalEmitted};
+
+        A a{};
+        registry.registerObject("a", &a);
+        QVERIFY(registry.isSignal("a.pinged"));
+
+        registry.call("a.ping", {});
+        QCOMPARE(spy.count(), 0);
+
+        registry.subscribe("a.pinged");
+        registry.call("a.ping", {});
+        QCOMPARE(spy.count(), 1);
+        QCOMPARE(spy[0][0].toString(), "a.pinged");
+        QCOMPARE(spy[0][1].toList(), QVariantList{"pong"});
+
+        registry.unsubscribe("a.pinged");
+        registry.call("a.ping", {});
+        QCOMPARE(spy.count(), 1);
+
+        // properties keep their keys
+        C c{};
+        registry.registerObject("c", &c);
+        QVERIFY(!registry.isSignal("c.pressed"));
+        QCOMPARE(registry.get("c.pressed"), true);
+
+        // queued emissions still on their way to a disconnected relay do not reach the next one
+        QList<int> tags;
+        SignalRelay relay{[&tags](int tag, const QVariantList &) { tags.append(tag); }};
+
+        const auto pinged = relay.connectSignal(&a, QMetaMethod::fromSignal(&A::pinged), 1, Qt::QueuedConnection);
+        a.ping();
+        relay.disconnectSignal(pinged);
+
+        const auto changed = relay.connectSignal(&a, QMetaMethod::fromSignal(&A::integerChanged), 2, Qt::QueuedConnection);
+        QVERIFY(changed != pinged);
+
+        QCoreApplication::processEvents();
+        QVERIFY(tags.isEmpty());
+    }
+
+    void remoteObject()
+    {
+        QThread thread{};
+        thread.start();
+
+        A a{};
+        a.setInteger(5);
+        a.moveToThread(&thread);
+
+        QObjectRegistry registry{};
+        registry.registerObject("a", &a);
+
+        // served from the mirrored values once they arrived
+        QTRY_COMPARE(registry.get("a.integer").toInt(), 5);
+
+        registry.set("a.integer", 7);
+        QTRY_COMPARE(registry.get("a.integer").toInt(), 7);
+
+        auto future = registry.callAsync("a.add", {1, 2});
+        QTRY_VERIFY(future.isFinished());
+        QCOMPARE(future.result().toInt(), 3);
+
+        registry.deregisterObject("a");
+        thread.quit();
+        thread.wait();
+    }
+
+    void asyncCall()
+    {
+        QObjectRegistry registry{};
+
+        A a{};
+        registry.registerObject("a", &a);
+
+        auto future = registry.callAsync("a.later", {});
+        QTRY_VERIFY(future.isFinished());
+        QCOMPARE(future.result().toString(), "later");
+
+        // concurrent methods only leave our thread with a pool
+        QCOMPARE(registry.callAsync("a.square", {3}).result().toInt(), 9);
+        QCOMPARE(a.squaredIn(), QThread::currentThread());
+
+        QThreadPool pool{};
+        registry.setThreadPool(&pool);
+
+        future = registry.callAsync("a.square", {4});
+        QTRY_VERIFY(future.isFinished());
+        QCOMPARE(future.result().toInt(), 16);
+        QVERIFY(a.squaredIn() != QThread::currentThread());
+
+        // an object gone before the pool got to its call cancels the call
+        pool.setMaxThreadCount(1);
+        QSemaphore busy{};
+        pool.start([&busy] { busy.acquire(); });
+
+        auto gone = new A{};
+        registry.registerObject("gone", gone);
+        future = registry.callAsync("gone.square", {5});
+        delete gone;
+        busy.release();
+
+        pool.waitForDone();
+        QTRY_VERIFY(future.isFinished());
+        QVERIFY(future.isCanceled());
+    }
+
+    void instrumentation()
+    {
+        QObjectRegistry registry{};
+
+        A a{};
+        registry.registerObject("a", &a);
+
+        registry.get("a.integer");
+        QVERIFY(registry.get("__stats.a.integer").toMap().isEmpty());
+
+        registry.stats().setEnabled(true);
+        registry.get("a.integer");
+        registry.get("a.integer");
+        registry.set("a.integer", 3);
+
+        const auto stats = registry.get("__stats.a.integer").toMap();
+        QCOMPARE(stats["get"].toMap()["count"].toInt(), 2);
+        QCOMPARE(stats["set"].toMap()["count"].toInt(), 1);
+        QVERIFY(!stats["get"].toMap()["latency"].toList().isEmpty());
+        QVERIFY(!stats.contains("call"));
+
+        QVERIFY(registry.snapshot("__stats.a.").contains("__stats.a.integer"));
+
+        // the stats of a key go with it
+        registry.deregisterObject("a");
+        QVERIFY(!registry.stats().keys().contains("a.integer"));
+        QVERIFY(registry.get("__stats.a.integer").toMap().isEmpty());
+    }
+
+    void queueStats()
+    {
+        QObjectRegistry registry{};
+        registry.stats().setEnabled(true);
+
+        // what outbound queues report, levels with their peak
+        auto stats = registry.stats().track("websocket");
+        stats->queue(3, 300);
+        stats->queue(-1, -100);
+
+        auto queue = registry.get("__stats.websocket").toMap()["queue"].toMap();
+        QCOMPARE(queue["messages"].toInt(), 2);
+        QCOMPARE(queue["bytes"].toInt(), 200);
+        QCOMPARE(queue["peak"].toInt(), 3);
+
+        registry.stats().reset();
+        queue = registry.get("__stats.websocket").toMap()["queue"].toMap();
+        QCOMPARE(queue["messages"].toInt(), 2);
+        QCOMPARE(queue["peak"].toInt(), 2);
+    }
+
+    void cborAdapter()
+    {
+        QObjectRegistry registry{};
+
+        A a{};
+        a.setInteger(7);
+        registry.registerObject("a", &a);
+
+        JSONAdapter adapter{registry, JSONAdapter::Cbor};
+        QSignalSpy spy{&adapter, &JSONAdapter::sendMessage};
+
+        const auto message = [](const QString &type, const QString &key) {
+            return QCborMap{{QLatin1String{"type"}, type}, {QLatin1String{"key"}, key}}.toCborValue().toCbor();
+        };
+        const auto reply = [&spy](int i) { return QCborValue::fromCbor(spy[i][0].toByteArray()).toMap(); };
+
+        adapter.handleMessage(message("subscribe", "a.integer"));
+        adapter.handleMessage(message("get", "a.string"));
+        a.setInteger(8);
+
+        QCOMPARE(spy.size(), 3);
+        QCOMPARE(reply(0)[QLatin1String{"type"}].toString(), "notify");
+        QCOMPARE(reply(0)[QLatin1String{"value"}].toInteger(), 7);
+        QCOMPARE(reply(1)[QLatin1String{"type"}].toString(), "return");
+        QCOMPARE(reply(1)[QLatin1String{"key"}].toString(), "a.string");
+        QCOMPARE(reply(2)[QLatin1String{"value"}].toInteger(), 8);
+    }
+
+    void adapterSet()
+    {
+        QObjectRegistry registry{};
+
+        A a{};
+        B b{};
+        b.setA(&a);
+        registry.registerObject("b", &b);
+
+        JSONAdapter adapter{registry};
+        adapter.handleMessage(R"({"type": "set", "key": "b.a.integer", "value": 2})");
+        QCOMPARE(a.integer(), 2);
+
+        // values that do not fit and objects from clients leave the property as it is
+        adapter.handleMessage(R"({"type": "set", "key": "b.a.integer", "value": "two"})");
+        QCOMPARE(a.integer(), 2);
+        adapter.handleMessage(R"({"type": "set", "key": "b.a.integer", "value": 2.5})");
+        QCOMPARE(a.integer(), 2);
+
+        adapter.handleMessage(R"({"type": "set", "key": "b.a", "value": 3})");
+        adapter.handleMessage(R"({"type": "set", "key": "b.a", "value": {"integer": 4}})");
+        QCOMPARE(b.a(), &a);
+    }
+
+    void sharedNotifyFrames()
+    {
+        QObjectRegistry registry{};
+
+        A a{};
+        registry.registerObject("a", &a);
+
+        JSONAdapter first{registry};
+        JSONAdapter second{registry};
+        QSignalSpy firstSpy{&first, &JSONAdapter::sendMessage};
+        QSignalSpy secondSpy{&second, &JSONAdapter::sendMessage};
+
+        first.handleMessage(R"({"type": "subscribe", "key": "a.numbers"})");
+        second.handleMessage(R"({"type": "subscribe", "key": "a.numbers"})");
+        a.setNumbers({1, 2, 3});
+
+        QCOMPARE(firstSpy.size(), 2);
+        QCOMPARE(secondSpy.size(), 2);
+
+        // encoded once, both clients send the same bytes
+        const auto frame = firstSpy[1][0].toByteArray();
+        QCOMPARE(QJsonDocument::fromJson(frame)["value"].toArray(), (QJsonArray{1, 2, 3}));
+        QVERIFY(frame.constData() == secondSpy[1][0].toByteArray().constData());
+    }
+
+    void sharedStatsFrames()
+    {
+        QObjectRegistry registry{};
+        registry.stats().setEnabled(true);
+
+        A a{};
+        registry.registerObject("a", &a);
+
+        JSONAdapter adapter{registry};
+        QList<int> counts;
+        connect(&adapter, &JSONAdapter::sendMessage, &registry, [&counts](const QByteArray &message) {
+            counts.append(QJsonDocument::fromJson(message)["value"]["get"]["count"].toInt());
+        });
+
+        adapter.handleMessage(R"({"type": "subscribe", "key": "__stats.a.integer"})");
+        registry.get("a.integer");
+        QTRY_VERIFY(counts.contains(1));
+
+        // stats change without a version, their frames are not shared between publishes
+        registry.get("a.integer");
+        QTRY_VERIFY(counts.contains(2));
+    }
+
+    void adapterInThread()
+    {
+        QObjectRegistry registry{};
+
+        A a{};
+        a.setInteger(7);
+        registry.registerObject("a", &a);
+
+        QThread thread{};
+        thread.start();
+
+        // created in the thread, so the adapter queues its registry access over to ours
+        QObject context{};
+        context.moveToThread(&thread);
+
+        JSONAdapter *adapter = nullptr;
+        QMetaObject::invokeMethod(&context, [&registry, &adapter] { adapter = new JSONAdapter{registry}; }, Qt::BlockingQueuedConnection);
+
+        QList<QJsonObject> messages;
+        connect(adapter, &JSONAdapter::sendMessage, &registry, [&messages](const QByteArray &message) {
+            messages.append(QJsonDocument::fromJson(message).object());
+        });
+
+        QMetaObject::invokeMethod(adapter, [adapter] {
+            adapter->handleMessage(R"({"type": "subscribe", "key": "a.integer"})");
+            adapter->handleMessage(R"({"type": "get", "key": "a.integer", "id": 1})");
+        });
+
+        QTRY_COMPARE(messages.size(), 2);
+        QCOMPARE(messages[0]["type"].toString(), "notify");
+        QCOMPARE(messages[0]["value"].toInt(), 7);
+        QCOMPARE(messages[1]["type"].toString(), "return");
+        QCOMPARE(messages[1]["id"].toInt(), 1);
+
+        a.setInteger(8);
+        QTRY_COMPARE(messages.size(), 3);
+        QCOMPARE(messages[2]["value"].toInt(), 8);
+
+        // keys subscribed by others do not cross over
+        registry.subscribe("a.string");
+        a.setString("elsewhere");
+        a.setInteger(9);
+        QTRY_COMPARE(messages.size(), 4);
+        QCOMPARE(messages[3]["key"].toString(), "a.integer");
+        QCOMPARE(messages[3]["value"].toInt(), 9);
+
+        adapter->deleteLater();
+        thread.quit();
+        thread.wait();
+    }
 };
 
 #include "qobjectregistry-test.moc"
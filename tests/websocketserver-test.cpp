@@ -0,0 +1,192 @@
+#include <memory>
+#include <vector>
+
+#include <QCborMap>
+#include <QCborValue>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThread>
+#include <QtTest/QSignalSpy>
+#include <QtTest/QTest>
+#include <QtWebSockets/QWebSocket>
+#include <QtWebSockets/QWebSocketHandshakeOptions>
+
+#include "qobjectregistry.h"
+#include "websocketserver.h"
+
+class A : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int integer READ integer WRITE setInteger NOTIFY integerChanged FINAL)
+
+public:
+    explicit A(QObject *parent = nullptr)
+        : QObject{parent}
+        , m_integer{0}
+    {}
+
+    int integer() const { return m_integer; }
+    void setInteger(int newInteger)
+    {
+        if (m_integer == newInteger)
+            return;
+        m_integer = newInteger;
+        emit integerChanged();
+    }
+
+    Q_INVOKABLE int add(int a, int b) { return a + b; }
+
+signals:
+    void integerChanged();
+
+private:
+    int m_integer;
+};
+
+// a client of the server in our thread, talking json or cbor as negotiated
+class Client : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit Client(quint16 port, const QStringList &subprotocols = {})
+    {
+        connect(&socket, &QWebSocket::textMessageReceived, this, [this](const QString &message) {
+            received.append(QJsonDocument::fromJson(message.toUtf8()).object());
+        });
+        connect(&socket, &QWebSocket::binaryMessageReceived, this, [this](const QByteArray &message) {
+            received.append(QCborValue::fromCbor(message).toMap().toJsonObject());
+        });
+
+        QWebSocketHandshakeOptions options{};
+        options.setSubprotocols(subprotocols);
+        socket.open(QUrl{QString{"ws://127.0.0.1:%1"}.arg(port)}, options);
+    }
+
+    void send(const QJsonObject &message)
+    {
+        if (socket.subprotocol() == "qopenremote.cbor")
+            socket.sendBinaryMessage(QCborValue::fromJsonValue(message).toCbor());
+        else
+            socket.sendTextMessage(QString::fromUtf8(QJsonDocument{message}.toJson(QJsonDocument::Compact)));
+    }
+
+    // the values notified for a key, in order
+    QList<int> notified(const QString &key) const
+    {
+        QList<int> values;
+
+        for (const auto &message : received)
+            if (message["type"].toString() == "notify" && message["key"].toString() == key)
+                values.append(message["value"].toInt());
+
+        return values;
+    }
+
+    QJsonObject returned(int id) const
+    {
+        for (const auto &message : received)
+            if (message["type"].toString() == "return" && message["id"].toInt() == id)
+                return message;
+
+        return {};
+    }
+
+    QWebSocket socket;
+    QList<QJsonObject> received;
+};
+
+class WebSocketServerTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void roundTrips()
+    {
+        QObjectRegistry registry{};
+
+        A a{};
+        registry.registerObject("a", &a);
+
+        WebSocketServer server{registry, 2};
+        QCOMPARE(server.workerCount(), 2);
+        QVERIFY(server.serverPort() > 0);
+
+        QSignalSpy connected{&server, &WebSocketServer::clientConnected};
+
+        // cbor if asked for, json for everyone else
+        Client json{server.serverPort()};
+        Client cbor{server.serverPort(), {"qopenremote.cbor"}};
+        Client other{server.serverPort(), {"other"}};
+
+        QTRY_COMPARE(json.socket.state(), QAbstractSocket::ConnectedState);
+        QTRY_COMPARE(cbor.socket.state(), QAbstractSocket::ConnectedState);
+        QTRY_COMPARE(other.socket.state(), QAbstractSocket::ConnectedState);
+        QTRY_COMPARE(connected.size(), 3);
+        QCOMPARE(server.clientCount(), 3);
+
+        QCOMPARE(json.socket.subprotocol(), QString{});
+        QCOMPARE(cbor.socket.subprotocol(), "qopenremote.cbor");
+        QCOMPARE(other.socket.subprotocol(), QString{});
+
+        // notifies start with the current value
+        json.send({{"type", "subscribe"}, {"key", "a.integer"}});
+        cbor.send({{"type", "subscribe"}, {"key", "a.integer"}});
+        QTRY_COMPARE(json.notified("a.integer"), QList<int>{0});
+        QTRY_COMPARE(cbor.notified("a.integer"), QList<int>{0});
+
+        // a set of one client reaches the registry and every subscriber, in whatever worker
+        other.send({{"type", "set"}, {"key", "a.integer"}, {"value", 5}});
+        QTRY_COMPARE(a.integer(), 5);
+        QTRY_COMPARE(json.notified("a.integer"), (QList<int>{0, 5}));
+        QTRY_COMPARE(cbor.notified("a.integer"), (QList<int>{0, 5}));
+        QVERIFY(other.notified("a.integer").isEmpty());
+
+        // returns go to the caller only, with its id
+        cbor.send({{"type", "call"}, {"key", "a.add"}, {"args", QJsonArray{2, 3}}, {"id", 7}});
+        other.send({{"type", "get"}, {"key", "a.integer"}, {"id", 8}});
+
+        QTRY_VERIFY(!cbor.returned(7).isEmpty());
+        QCOMPARE(cbor.returned(7)["value"].toInt(), 5);
+        QTRY_VERIFY(!other.returned(8).isEmpty());
+        QCOMPARE(other.returned(8)["value"].toInt(), 5);
+        QVERIFY(json.returned(7).isEmpty());
+    }
+
+    void leastLoaded()
+    {
+        QObjectRegistry registry{};
+        WebSocketServer server{registry, 2};
+
+        // the accepted descriptor is handed to a worker, the client lives in the worker's thread
+        QStringList threads;
+        connect(&server, &WebSocketServer::clientConnected, this, [&threads](QWebSocket *client) {
+            threads.append(client->thread()->objectName());
+        });
+
+        std::vector<std::unique_ptr<Client>> clients;
+
+        // one at a time, so every client finds the counts of the ones before
+        for (int i = 0; i < 6; ++i) {
+            // with the clients of one worker gone, the next ones all go there
+            if (i == 4) {
+                clients[1]->socket.close();
+                clients[3]->socket.close();
+                QTRY_COMPARE(server.clientCount(), 2);
+            }
+
+            clients.push_back(std::make_unique<Client>(server.serverPort()));
+            QTRY_COMPARE(clients.back()->socket.state(), QAbstractSocket::ConnectedState);
+            QTRY_COMPARE(threads.size(), qsizetype(clients.size()));
+        }
+
+        // equally loaded workers take turns
+        QCOMPARE(threads, (QStringList{"websocket-0", "websocket-1", "websocket-0", "websocket-1", "websocket-1", "websocket-1"}));
+        QCOMPARE(server.clientCount(), 4);
+    }
+};
+
+#include "websocketserver-test.moc"
+
+QTEST_MAIN(WebSocketServerTest)